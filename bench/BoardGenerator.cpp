@@ -0,0 +1,84 @@
+
+#include "BoardGenerator.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+static const char* BOGGLE_DICE[16] = {
+	"AAEEGN", "ABBJOO", "ACHOPS", "AFFKPS", "AOOTTW", "CIMOTU", "DEILRX", "DELRVY",
+	"DISTTY", "EEGHNW", "EEINSU", "EHRTVW", "EIOSST", "ELRTTY", "HIMNQU", "HLNNRZ" };
+
+static const char* BIG_BOGGLE_DICE[25] = {
+	"AAAFRS", "AAEEEE", "AAFIRS", "ADENNN", "AEEEEM", "AEEGMU", "AEGMNN", "AFIRSY",
+	"BJKQXZ", "CCNSTW", "CEIILT", "CEILPT", "CEIPST", "DDLNOR", "DHHLOR", "DHHNOT",
+	"DHLNOR", "EIIITT", "EMOTTT", "ENSSSU", "FIPRSY", "GORRVW", "HIPRRY", "NOOTUW",
+	"OOOTTU" };
+
+
+char BoardGenerator::roll( const char* die )
+{
+	return die[rng() % 6];
+}
+
+std::string BoardGenerator::board( int nRows, int nCols )
+{
+	const int size = nRows*nCols;
+	std::string result( size, ' ' );
+	std::vector<const char*> dice;
+	if ( size == 16 )
+	{
+		dice.assign( BOGGLE_DICE, BOGGLE_DICE + 16 );
+	}
+	else if ( size == 25 )
+	{
+		dice.assign( BIG_BOGGLE_DICE, BIG_BOGGLE_DICE + 25 );
+	}
+	else
+	{
+		for ( int i = 0; i < size; ++i )
+		{
+			dice.push_back( BIG_BOGGLE_DICE[rng() % 25] );
+		}
+	}
+	// Shake the dice into the grid, then roll each one. The shuffle is written
+	//   out (rather than std::shuffle) so a seed means the same boards everywhere.
+	for ( int i = size - 1; i > 0; --i )
+	{
+		std::swap( dice[i], dice[rng() % (i + 1)] );
+	}
+	for ( int i = 0; i < size; ++i )
+	{
+		result[i] = roll( dice[i] );
+	}
+	return result;
+}
+
+std::vector<std::string> BoardGenerator::corpus( int nRows, int nCols, int count )
+{
+	std::vector<std::string> boards;
+	for ( int i = 0; i < count; ++i )
+	{
+		boards.push_back( board( nRows, nCols ) );
+	}
+	return boards;
+}
+
+std::vector<std::string> loadBoards( const char* file )
+{
+	std::vector<std::string> boards;
+	std::ifstream input( file );
+	std::string line;
+	while ( std::getline( input, line ) )
+	{
+		if ( !line.empty() && line[line.size()-1] == '\r' )
+		{
+			line.erase( line.size()-1 );
+		}
+		if ( !line.empty() && line[0] != '#' )
+		{
+			boards.push_back( line );
+		}
+	}
+	return boards;
+}
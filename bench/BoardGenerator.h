@@ -0,0 +1,31 @@
+
+#ifndef _BOARDGENERATOR_H
+#define _BOARDGENERATOR_H
+
+#include <string>
+#include <vector>
+#include <random>
+#include <stdint.h>
+
+// Seeded random boards that look like real games. Boards are rolled from
+//   letter dice: the 16 classic Boggle dice for 4x4, the 25 Big Boggle dice
+//   for 5x5, and for any other size every cell rolls a die picked at random
+//   from the Big Boggle set. A "Qu" face is a plain Q since a cell holds one
+//   letter. The same seed always produces the same boards.
+class BoardGenerator
+{
+public:
+	explicit BoardGenerator( uint32_t seed ) : rng(seed) {}
+
+	std::string board( int nRows, int nCols );
+	std::vector<std::string> corpus( int nRows, int nCols, int count );
+private:
+	std::mt19937 rng;
+
+	char roll( const char* die );
+};
+
+// One board per line; blank lines and lines starting with '#' are skipped.
+std::vector<std::string> loadBoards( const char* file );
+
+#endif
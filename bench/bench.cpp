@@ -0,0 +1,528 @@
+/*
+ * Micro and macro benchmarks for the solver. Run with 'make bench'.
+ *
+ *   ./wordHeroBench [-b baseline.txt] [-w baseline.txt] [-s seed]
+ *
+ *   -b  compare every measurement against a saved baseline
+ *   -w  write this run's measurements as the new baseline
+ *   -s  seed for the generated board corpora (default 1)
+ *
+ * The corpora are rolled from Boggle dice with a fixed seed, so two runs on
+ *   the same machine solve exactly the same boards. bench/boards/ holds a
+ *   frozen snapshot of boards that is solved as an extra corpus.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <unistd.h>
+
+#include "BoardGenerator.h"
+#include "../src/WordHeroSolver.h"
+#include "../src/BatchSolver.h"
+#include "../src/Dictionary.h"
+#include "../src/Dawg.h"
+#include "../src/Topology.h"
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+struct Measurement
+{
+	string name;
+	double value;
+	string unit;
+	bool higherIsBetter;
+};
+
+static vector<Measurement> measurements;
+// Keeps the optimizer from discarding work whose result is otherwise unused.
+static volatile long sink;
+
+// Every heap allocation the program makes, for the allocation counts below.
+static long heapAllocations;
+
+void* operator new( size_t size )
+{
+	heapAllocations += 1;
+	void* block = malloc( size ? size : 1 );
+	if ( !block )
+	{
+		throw bad_alloc();
+	}
+	return block;
+}
+
+void operator delete( void* block ) noexcept
+{
+	free( block );
+}
+
+static double elapsedNs( Clock::time_point start )
+{
+	return chrono::duration<double, nano>( Clock::now() - start ).count();
+}
+
+static void record( const string& name, double value, const string& unit, bool higherIsBetter )
+{
+	Measurement m = { name, value, unit, higherIsBetter };
+	measurements.push_back( m );
+}
+
+static double percentile( vector<double> samples, double p )
+{
+	sort( samples.begin(), samples.end() );
+	size_t idx = size_t( p * (samples.size() - 1) + 0.5 );
+	return samples[idx];
+}
+
+//
+// MICROBENCHMARKS
+//
+
+// Walks dictionary words through the DAWG one child-list scan per letter,
+//   which is the lookup solvehelper does for every board cell it visits.
+static void benchDawgChildLookup( const Dictionary& dictionary )
+{
+	const int* dawg = dictionary.nodes();
+	mt19937 rng( 7 );
+	vector<string> words;
+	for ( int i = 0; i < 20000; ++i )
+	{
+		words.push_back( dictionary.word( rng() % dictionary.numberOfWords() ) );
+	}
+
+	long lookups = 0, found = 0;
+	Clock::time_point start = Clock::now();
+	for ( int repeat = 0; repeat < 20; ++repeat )
+	{
+		for ( size_t w = 0; w < words.size(); ++w )
+		{
+			const string& word = words[w];
+			int dawgIdx = word[0] - 'A' + 1;
+			for ( size_t i = 1; i < word.size() && dawgIdx; ++i )
+			{
+				dawgIdx = DAWG_CHILD(dawg, dawgIdx);
+				while ( dawgIdx && DAWG_LETTER(dawg, dawgIdx) != word[i] )
+				{
+					dawgIdx = DAWG_NEXT(dawg, dawgIdx);
+				}
+				lookups += 1;
+			}
+			found += dawgIdx ? 1 : 0;
+		}
+	}
+	sink = found;
+	record( "micro.dawg_child_lookup", elapsedNs( start ) / lookups, "ns/lookup", false );
+}
+
+// A full solve of one board is the cost of the solvehelper recursion from
+//   every cell, so this times solve() on a small fixed set of boards.
+static void benchSolvehelper( WordHeroSolver& solver, const vector<string>& boards )
+{
+	solver.setEngine( WordHeroSolver::ENGINE_BOARD );
+	double best = 1e300;
+	for ( int repeat = 0; repeat < 5; ++repeat )
+	{
+		Clock::time_point start = Clock::now();
+		for ( size_t i = 0; i < boards.size(); ++i )
+		{
+			solver.solve( boards[i] );
+		}
+		best = min( best, elapsedNs( start ) / boards.size() );
+	}
+	record( "micro.solvehelper_4x4", best, "ns/board", false );
+
+	// The same boards breadth-first, merging paths over the same cells.
+	solver.setEngine( WordHeroSolver::ENGINE_FRONTIER );
+	best = 1e300;
+	for ( int repeat = 0; repeat < 5; ++repeat )
+	{
+		Clock::time_point start = Clock::now();
+		for ( size_t i = 0; i < boards.size(); ++i )
+		{
+			solver.solve( boards[i] );
+		}
+		best = min( best, elapsedNs( start ) / boards.size() );
+	}
+	record( "micro.frontier_4x4", best, "ns/board", false );
+	solver.setEngine( WordHeroSolver::ENGINE_AUTO );
+}
+
+// The count/score-only walk over the same boards as the full solve.
+static void benchSummarize( WordHeroSolver& solver, const vector<string>& boards )
+{
+	double best = 1e300;
+	SolveSummary summary;
+	long words = 0;
+	for ( int repeat = 0; repeat < 5; ++repeat )
+	{
+		Clock::time_point start = Clock::now();
+		for ( size_t i = 0; i < boards.size(); ++i )
+		{
+			solver.summarize( boards[i], summary );
+			words += summary.words;
+		}
+		best = min( best, elapsedNs( start ) / boards.size() );
+	}
+	sink = words;
+	record( "micro.summarize_4x4", best, "ns/board", false );
+}
+
+// The ten longest words of a large board, which the deadline mode can find
+//   without walking every branch of the full solve.
+static void benchTopK( const Dictionary& dictionary, const vector<string>& boards )
+{
+	WordHeroSolver solver( dictionary, 20, 20 );
+	vector<string> words;
+	Clock::time_point start = Clock::now();
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		solver.solveTopK( boards[i], 10, WordHeroSolver::RANK_BY_LENGTH, chrono::seconds( 10 ), words );
+	}
+	sink = words.size();
+	record( "micro.top10_20x20", elapsedNs( start ) / boards.size(), "ns/board", false );
+}
+
+// Anchor queries on every cell of a board, with the GADDAG when gaddag.dat
+//   is present (the bench targets build it).
+static void benchSolveThrough( const vector<string>& boards )
+{
+	Dictionary dictionary;
+	if ( !dictionary.load( "dictionary.dat" ) || !dictionary.loadGaddag( "gaddag.dat" ) )
+	{
+		return;
+	}
+	WordHeroSolver solver( dictionary, 20, 20 );
+	long words = 0;
+	Clock::time_point start = Clock::now();
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		for ( int cell = 0; cell < 20*20; ++cell )
+		{
+			solver.solveThrough( boards[i], cell / 20, cell % 20 );
+			words += distance( solver.begin(), solver.end() );
+		}
+	}
+	sink = words;
+	record( "micro.through_20x20", elapsedNs( start ) / (boards.size()*20*20), "ns/query", false );
+}
+
+// The depth-first and dictionary-driven engines on the same large boards.
+static void benchEngines( const Dictionary& dictionary, const vector<string>& boards )
+{
+	WordHeroSolver solver( dictionary, 50, 50 );
+	const WordHeroSolver::Engine engines[] = { WordHeroSolver::ENGINE_BOARD, WordHeroSolver::ENGINE_DICTIONARY,
+						WordHeroSolver::ENGINE_INTERLEAVED };
+	const char* names[] = { "micro.board_engine_50x50", "micro.dictionary_engine_50x50",
+				"micro.interleaved_engine_50x50" };
+	for ( int e = 0; e < 3; ++e )
+	{
+		solver.setEngine( engines[e] );
+		long words = 0;
+		Clock::time_point start = Clock::now();
+		for ( size_t i = 0; i < boards.size(); ++i )
+		{
+			solver.solve( boards[i] );
+			words += distance( solver.begin(), solver.end() );
+		}
+		sink = words;
+		record( names[e], elapsedNs( start ) / boards.size(), "ns/board", false );
+	}
+}
+
+// The 20x20 corpus on other board layouts, with the engine solve() picks.
+static void benchTopologies( const Dictionary& dictionary, const vector<string>& boards )
+{
+	const Topology topologies[] = { Topology::hex( 20, 20 ), Topology::torus( 20, 20 ) };
+	const char* names[] = { "micro.hex_20x20", "micro.torus_20x20" };
+	WordHeroSolver solver( dictionary, 20, 20 );
+	for ( int t = 0; t < 2; ++t )
+	{
+		solver.setTopology( &topologies[t] );
+		long words = 0;
+		Clock::time_point start = Clock::now();
+		for ( size_t i = 0; i < boards.size(); ++i )
+		{
+			solver.solve( boards[i] );
+			words += distance( solver.begin(), solver.end() );
+		}
+		sink = words;
+		record( names[t], elapsedNs( start ) / boards.size(), "ns/board", false );
+	}
+}
+
+// The lockstep batch on the same boards as micro.solvehelper_4x4.
+static void benchBatch( const Dictionary& dictionary, const vector<string>& boards )
+{
+	BatchSolver batch( dictionary, 4, 4 );
+	double best = 1e300;
+	for ( int repeat = 0; repeat < 5; ++repeat )
+	{
+		Clock::time_point start = Clock::now();
+		batch.solve( boards );
+		best = min( best, elapsedNs( start ) / boards.size() );
+	}
+	sink = batch.wordIds( 0 ).size();
+	record( "micro.batch_4x4", best, "ns/board", false );
+}
+
+// Copies each result set out of the solver, as every front end has to.
+static void benchResultCollection( WordHeroSolver& solver, const vector<string>& boards )
+{
+	double total = 0;
+	long words = 0;
+	vector<string> collected;
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		solver.solve( boards[i] );
+		Clock::time_point start = Clock::now();
+		collected.assign( solver.begin(), solver.end() );
+		total += elapsedNs( start );
+		words += collected.size();
+	}
+	sink = words;
+	record( "micro.result_collection", words ? total / words : 0, "ns/word", false );
+}
+
+// Heap allocations per board in steady state: solve() against the
+//   arena-backed solveView(), after one warm-up pass over the boards.
+static void benchSolveView( const Dictionary& dictionary, const vector<string>& boards )
+{
+	WordHeroSolver solver( dictionary, 4, 4 );
+	long words = 0;
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		solver.solve( boards[i] );
+		solver.solveView( boards[i].data(), boards[i].size() );
+	}
+	long before = heapAllocations;
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		solver.solve( boards[i] );
+	}
+	record( "micro.solve_allocations", double(heapAllocations - before) / boards.size(), "allocs/board", false );
+
+	before = heapAllocations;
+	Clock::time_point start = Clock::now();
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		words += solver.solveView( boards[i].data(), boards[i].size() ).size();
+	}
+	const double ns = elapsedNs( start );
+	record( "micro.view_allocations", double(heapAllocations - before) / boards.size(), "allocs/board", false );
+	record( "micro.view_4x4", ns / boards.size(), "ns/board", false );
+	sink = words;
+}
+
+// Where the search spends its time, summed over a corpus. Only available in
+//   a 'make COUNTERS=1' build; the timed benchmarks above run without it.
+static void reportCounters( WordHeroSolver& solver, const vector<string>& boards )
+{
+	if ( !SolverCounters::enabled )
+	{
+		return;
+	}
+	// The counters instrument solvehelper, which only the board engine runs.
+	solver.setEngine( WordHeroSolver::ENGINE_BOARD );
+	SolverCounters total;
+	vector<uint64_t> startCellNs;
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		solver.solve( boards[i] );
+		const SolverCounters& c = solver.counters();
+		total.nodesExpanded += c.nodesExpanded;
+		total.visitedRejects += c.visitedRejects;
+		total.siblingScans += c.siblingScans;
+		total.siblingSteps += c.siblingSteps;
+		for ( int j = 0; j < SolverCounters::MAX_SCAN; ++j )
+		{
+			total.scanLengths[j] += c.scanLengths[j];
+		}
+		for ( int j = 0; j < SolverCounters::MAX_DEPTH; ++j )
+		{
+			total.pruneDepths[j] += c.pruneDepths[j];
+		}
+		total.wordsFound += c.wordsFound;
+		total.duplicateHits += c.duplicateHits;
+		startCellNs.resize( c.startCellNs.size() );
+		for ( size_t j = 0; j < c.startCellNs.size(); ++j )
+		{
+			startCellNs[j] += c.startCellNs[j];
+		}
+	}
+	const double n = boards.size();
+	cout << "counters per board (" << boards.size() << " boards)\n"
+		 << "  nodes expanded    " << total.nodesExpanded / n << '\n'
+		 << "  visited rejects   " << total.visitedRejects / n << '\n'
+		 << "  sibling scans     " << total.siblingScans / n
+		 << "  (" << double(total.siblingSteps) / max<uint64_t>( total.siblingScans, 1 ) << " entries/scan)\n"
+		 << "  words found       " << total.wordsFound / n << '\n'
+		 << "  duplicate hits    " << total.duplicateHits / n << '\n'
+		 << "  prune depth       ";
+	for ( int j = 0; j < SolverCounters::MAX_DEPTH; ++j )
+	{
+		if ( total.pruneDepths[j] )
+		{
+			cout << j << ':' << total.pruneDepths[j] / n << ' ';
+		}
+	}
+	cout << "\n  start cell ns     ";
+	for ( size_t j = 0; j < startCellNs.size(); ++j )
+	{
+		cout << startCellNs[j] / n << ' ';
+	}
+	cout << "\n\n";
+}
+
+//
+// MACROBENCHMARKS
+//
+
+static void benchCorpus( const Dictionary& dictionary, const string& name,
+				int nRows, int nCols, const vector<string>& boards )
+{
+	if ( boards.empty() )
+	{
+		return;
+	}
+	WordHeroSolver solver( dictionary, nRows, nCols );
+	vector<double> latencies;
+	long words = 0;
+	Clock::time_point start = Clock::now();
+	for ( size_t i = 0; i < boards.size(); ++i )
+	{
+		Clock::time_point boardStart = Clock::now();
+		solver.solve( boards[i] );
+		words += distance( solver.begin(), solver.end() );
+		latencies.push_back( elapsedNs( boardStart ) / 1000 );
+	}
+	double seconds = elapsedNs( start ) / 1e9;
+	record( "macro." + name + ".boards_per_sec", boards.size() / seconds, "boards/s", true );
+	record( "macro." + name + ".p50", percentile( latencies, 0.50 ), "us", false );
+	record( "macro." + name + ".p99", percentile( latencies, 0.99 ), "us", false );
+	record( "macro." + name + ".words_per_board", double(words) / boards.size(), "words", true );
+}
+
+//
+// BASELINE
+//
+
+static map<string, double> readBaseline( const char* file )
+{
+	map<string, double> baseline;
+	ifstream input( file );
+	string name;
+	double value;
+	while ( input >> name >> value )
+	{
+		baseline[name] = value;
+	}
+	return baseline;
+}
+
+static void writeBaseline( const char* file )
+{
+	ofstream output( file );
+	for ( size_t i = 0; i < measurements.size(); ++i )
+	{
+		output << measurements[i].name << ' ' << measurements[i].value << '\n';
+	}
+}
+
+static void report( const map<string, double>& baseline )
+{
+	cout << left << setw( 36 ) << "benchmark" << right << setw( 14 ) << "value"
+		 << "  " << left << setw( 10 ) << "unit" << right << setw( 14 ) << "baseline" << setw( 10 ) << "change" << '\n';
+	for ( size_t i = 0; i < measurements.size(); ++i )
+	{
+		const Measurement& m = measurements[i];
+		cout << left << setw( 36 ) << m.name << right << setw( 14 ) << fixed << setprecision( 2 ) << m.value
+			 << "  " << left << setw( 10 ) << m.unit;
+		map<string, double>::const_iterator itr = baseline.find( m.name );
+		if ( itr != baseline.end() && itr->second != 0 )
+		{
+			double change = 100.0 * (m.value - itr->second) / itr->second;
+			// Flag anything that moved more than 10% in the wrong direction.
+			bool isRegression = m.higherIsBetter ? change < -10 : change > 10;
+			cout << right << setw( 14 ) << itr->second << setw( 9 ) << showpos << change << noshowpos << '%'
+				 << (isRegression ? "  REGRESSION" : "");
+		}
+		cout << '\n';
+	}
+}
+
+int main( int argc, char* argv[] )
+{
+	const char* baselineFile = NULL;
+	const char* saveFile = NULL;
+	uint32_t seed = 1;
+	int opt;
+	while ( (opt = getopt( argc, argv, "b:w:s:" )) != -1 )
+	{
+		switch ( opt )
+		{
+		case 'b':
+			baselineFile = optarg;
+			break;
+		case 'w':
+			saveFile = optarg;
+			break;
+		case 's':
+			seed = atoi( optarg );
+			break;
+		default:
+			cerr << "usage: " << argv[0] << " [-b baseline.txt] [-w baseline.txt] [-s seed]" << endl;
+			exit(1);
+		}
+	}
+
+	Dictionary dictionary;
+	if ( !dictionary.load( "dictionary.dat" ) )
+	{
+		cerr << "could not initialize the DAWG (bad file?)" << endl;
+		exit(1);
+	}
+
+	BoardGenerator generator( seed );
+	vector<string> boards4x4 = generator.corpus( 4, 4, 1000 );
+	vector<string> boards5x5 = generator.corpus( 5, 5, 300 );
+	vector<string> boards20x20 = generator.corpus( 20, 20, 20 );
+	vector<string> boards50x50 = generator.corpus( 50, 50, 4 );
+	vector<string> snapshot4x4 = loadBoards( "bench/boards/snapshot-4x4.txt" );
+
+	WordHeroSolver solver( dictionary, 4, 4 );
+	vector<string> microBoards( boards4x4.begin(), boards4x4.begin() + 100 );
+	benchDawgChildLookup( dictionary );
+	benchSolvehelper( solver, microBoards );
+	benchSummarize( solver, microBoards );
+	benchBatch( dictionary, microBoards );
+	benchResultCollection( solver, microBoards );
+	benchSolveView( dictionary, microBoards );
+	benchTopK( dictionary, boards20x20 );
+	benchSolveThrough( boards20x20 );
+	benchEngines( dictionary, boards50x50 );
+	benchTopologies( dictionary, boards20x20 );
+
+	benchCorpus( dictionary, "4x4", 4, 4, boards4x4 );
+	benchCorpus( dictionary, "5x5", 5, 5, boards5x5 );
+	benchCorpus( dictionary, "20x20", 20, 20, boards20x20 );
+	benchCorpus( dictionary, "snapshot_4x4", 4, 4, snapshot4x4 );
+
+	reportCounters( solver, microBoards );
+	report( baselineFile ? readBaseline( baselineFile ) : map<string, double>() );
+	if ( saveFile )
+	{
+		writeBaseline( saveFile );
+	}
+	return 0;
+}
@@ -16,6 +16,10 @@
 // *** MAX is the length of the longest word in the list. Change this value.
 // *** MIN is the length of the shortest word in the list.  Change this value.
 
+// Compiled with "-DGADDAG", this program writes "gaddag.dat" instead: a GADDAG of the same list.  For every word
+// x1..xn and every split 1 <= i <= n, it stores "rev(x1..xi) + GADDAG_SEPARATOR + x(i+1)..xn", without the separator
+// when i == n.  Walking it from any letter of a word reads the word outward, first backward and then forward.
+
 // Include the big-three header files.
 #include <stdlib.h>
 #include <stdio.h>
@@ -24,8 +28,15 @@
 // General high-level program constants.
 #define MERGE_SORT_THRESHOLD 1
 #define MIN 2
+#ifdef GADDAG
+// The longest word is 15 letters, and a GADDAG string adds a separator.
+#define MAX 16
+#define SIZE_OF_CHARACTER_SET 27
+#define GADDAG_SEPARATOR '>'
+#else
 #define MAX 15
 #define SIZE_OF_CHARACTER_SET 26
+#endif
 #define INPUT_LIMIT 35
 #define LOWER_IT 32
 #define TEN 10
@@ -50,7 +61,11 @@ typedef Bool* BoolPtr;
 #define RAW_LEXICON "Word-List.txt"
 
 // This program will create "1" binary-data file for use, and "1" text-data file for inspection.
+#ifdef GADDAG
+#define TRADITIONAL_DAWG_DATA "gaddag.dat"
+#else
 #define TRADITIONAL_DAWG_DATA "dictionary.dat"
+#endif
 
 // An explicit table-lookup CRC calculation will be used to identify unique graph branch configurations.
 #define LOOKUP_TABLE_DATA "CRC-32.dat"
@@ -65,11 +80,19 @@ const int PowersOfTwo[INT_BITS] = { 0X1, 0X2, 0X4, 0X8, 0X10, 0X20, 0X40, 0X80,
 const int PowersOfTen[TEN] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
 
 const unsigned char CharacterSet[SIZE_OF_CHARACTER_SET] = { 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K',
- 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z' };
+ 'L', 'M', 'N', 'O', 'P', 'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z'
+#ifdef GADDAG
+ , GADDAG_SEPARATOR
+#endif
+ };
  
  // Some word lists will contain letters that NO words begin with.  Place "0"s in the corresponding positions.
 const unsigned char EntryNodeIndex[SIZE_OF_CHARACTER_SET] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19,
- 20, 21, 22, 23, 24, 25, 26 };
+ 20, 21, 22, 23, 24, 25, 26
+#ifdef GADDAG
+ , 0
+#endif
+ };
 
 // This simple function clips off the extra chars for each "fgets()" line.  Works for Linux and Windows text format.
 void CutOffExtraChars(char *ThisLine){
@@ -1228,7 +1251,15 @@ int main(){
 	printf("\n  FirstLineIsSize = Number-Of-Words = |%d|\n", FirstLineIsSize);
 	int DictionarySizeIndex[MAX + 1];
 	for ( X = 0; X <= MAX; X++ ) DictionarySizeIndex[X] = 0;
+#ifdef GADDAG
+	// A word of length n becomes n GADDAG strings.
+	char **LexiconInRam = (char**)malloc(FirstLineIsSize*(MAX - 1)*sizeof(char *));
+	int NumberOfStrings = 0;
+	int Split;
+#else
 	char **LexiconInRam = (char**)malloc(FirstLineIsSize*sizeof(char *)); 
+	int NumberOfStrings = FirstLineIsSize;
+#endif
 
 	// The first line is the Number-Of-Words, so read them all into RAM, temporarily.
 	for ( X = 0; X < FirstLineIsSize; X++ ) {
@@ -1237,6 +1268,24 @@ int main(){
 		MakeMeAllCapital(ThisLine);
 		if ( !TestForValidWord(ThisLine) ) printf("Invalid Word @ |%d|-|%s|\n", X, ThisLine);
 		LineLength = strlen(ThisLine);
+#ifdef GADDAG
+		if ( LineLength >= MAX ) {
+			printf("The word in position |%d| is too long.  EXIT.\n", X);
+			return 0;
+		}
+		for ( Split = 1; Split <= LineLength; Split++ ) {
+			int StringLength = (Split < LineLength)? LineLength + 1: LineLength;
+			char *GaddagString = (unsigned char *)malloc((StringLength + 1)*sizeof(unsigned char));
+			for ( Y = 0; Y < Split; Y++ ) GaddagString[Y] = ThisLine[Split - 1 - Y];
+			if ( Split < LineLength ) {
+				GaddagString[Split] = GADDAG_SEPARATOR;
+				strcpy(GaddagString + Split + 1, ThisLine + Split);
+			}
+			else GaddagString[Split] = '\0';
+			DictionarySizeIndex[StringLength] += 1;
+			LexiconInRam[NumberOfStrings++] = GaddagString;
+		}
+#else
 		if ( LineLength <= MAX ) DictionarySizeIndex[LineLength] += 1;
 		else {
 			printf("The word in position |%d| is too long.  EXIT.\n", X);
@@ -1244,6 +1293,7 @@ int main(){
 		}
 		LexiconInRam[X] = (unsigned char *)malloc((LineLength + 1)*sizeof(unsigned char));
 		strcpy(LexiconInRam[X], ThisLine);
+#endif
 	}
 	printf("\n  Word-List.txt is now in RAM.\n");
 	// Allocate enough space to hold all of the words in "unsigned char" arrays holding character indexes.
@@ -1254,7 +1304,7 @@ int main(){
 	unsigned char CurrentWordByIndex[MAX];
 	int CurrentLength;
 	// Copy all of the words into the "LetterIndex" format "AllWordsInEnglish" array.
-	for ( X = 0; X < FirstLineIsSize; X++ ) {
+	for ( X = 0; X < NumberOfStrings; X++ ) {
 		CurrentLength = strlen(LexiconInRam[X]);
 		// Convert each string from its temporary ram location into the "LetterIndex" format, and copy that into "AllWordsInEnglish".
 		LettersToIndexConversion(LexiconInRam[X], CurrentWordByIndex);
@@ -1269,7 +1319,7 @@ int main(){
 	}
 	
 	// Free the the initial dynamically allocated memory.
-	for ( X = 0; X < FirstLineIsSize; X++ ) free(LexiconInRam[X]);
+	for ( X = 0; X < NumberOfStrings; X++ ) free(LexiconInRam[X]);
 	free(LexiconInRam);
 	
 	printf("\n  Begin Creator init function.\n\n");
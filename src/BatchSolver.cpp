@@ -0,0 +1,158 @@
+
+#include "BatchSolver.h"
+#include "Dawg.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
+static bool shorterWord( const std::string& lhs, const std::string& rhs )
+{
+	return lhs.size() < rhs.size();
+}
+
+
+BatchSolver::BatchSolver( const Dictionary& dictionary, int NRows, int NCols )
+	: dictionary(dictionary), dawg(dictionary.nodes()), topology(Topology::grid( NRows, NCols )),
+	  letterBits(NRows*NCols*LANES, 0), visited(NRows*NCols, 0), firstResult(0)
+{
+	for ( int lane = 0; lane < LANES; ++lane )
+	{
+		seen[lane].assign( (dictionary.numberOfWords() + 63) / 64, 0 );
+	}
+}
+
+BatchSolver::BatchSolver( const Dictionary& dictionary, const Topology& topology )
+	: dictionary(dictionary), dawg(dictionary.nodes()), topology(topology),
+	  letterBits(topology.cells()*LANES, 0), visited(topology.cells(), 0), firstResult(0)
+{
+	for ( int lane = 0; lane < LANES; ++lane )
+	{
+		seen[lane].assign( (dictionary.numberOfWords() + 63) / 64, 0 );
+	}
+}
+
+void BatchSolver::solve( const std::vector<std::string>& boards )
+{
+	results.assign( boards.size(), std::vector<int>() );
+	for ( size_t first = 0; first < boards.size(); first += LANES )
+	{
+		solveLanes( boards, first, std::min( size_t(LANES), boards.size() - first ) );
+	}
+}
+
+void BatchSolver::words( int board, std::vector<std::string>& out ) const
+{
+	const std::vector<int>& ids = results[board];
+	out.clear();
+	for ( size_t i = 0; i < ids.size(); ++i )
+	{
+		out.push_back( dictionary.word( ids[i] ) );
+	}
+	// Ids are alphabetical, so this sorts by length, then alphabetically.
+	std::stable_sort( out.begin(), out.end(), shorterWord );
+}
+
+void BatchSolver::solveLanes( const std::vector<std::string>& boards, int first, int count )
+{
+	const int boardSize = topology.cells();
+	for ( int cell = 0; cell < boardSize; ++cell )
+	{
+		for ( int lane = 0; lane < LANES; ++lane )
+		{
+			const std::string* board = lane < count ? &boards[first + lane] : NULL;
+			const int c = board && cell < int(board->size()) ? (*board)[cell] - 'A' : -1;
+			letterBits[cell*LANES + lane] = c >= 0 && c < 26 ? uint32_t(1) << c : 0;
+		}
+	}
+
+	firstResult = first;
+	const uint32_t lanes = (uint32_t(1) << count) - 1;
+	for ( int cell = 0; cell < boardSize; ++cell )
+	{
+		extend( 0, cell, lanes );
+	}
+
+	for ( int lane = 0; lane < count; ++lane )
+	{
+		std::vector<int>& ids = results[first + lane];
+		std::sort( ids.begin(), ids.end() );
+		for ( size_t i = 0; i < ids.size(); ++i )
+		{
+			seen[lane][ids[i] / 64] = 0;
+		}
+	}
+}
+
+// Steps every live lane onto cell: nodes[depth] and ranks[depth] get each
+//   lane's DAWG node and first word id after the letter there, or node 0
+//   where the prefix has no word. The lanes that can still grow then go on
+//   to every unvisited neighbor together.
+void BatchSolver::extend( int depth, int cell, uint32_t live )
+{
+	const uint32_t* letters = &letterBits[cell*LANES];
+	int* node = nodes[depth];
+	int* rank = ranks[depth];
+	uint32_t growing = 0;
+	if ( depth == 0 )
+	{
+		for ( uint32_t todo = live; todo; todo &= todo - 1 )
+		{
+			const int lane = __builtin_ctz( todo );
+			const uint32_t bit = letters[lane];
+			const int dawgIdx = bit ? dictionary.entryNode( 'A' + __builtin_ctz( bit ) ) : 0;
+			node[lane] = dawgIdx;
+			rank[lane] = dawgIdx ? dictionary.rankStep( 0, 0, dawgIdx ) : 0;
+			growing |= dawgIdx && dictionary.childLetters( dawgIdx ) ? uint32_t(1) << lane : 0;
+		}
+	}
+	else
+	{
+		const int* parent = nodes[depth-1];
+		const int* parentRank = ranks[depth-1];
+		for ( uint32_t todo = live; todo; todo &= todo - 1 )
+		{
+			const int lane = __builtin_ctz( todo );
+			const int parentIdx = parent[lane];
+			const uint32_t choices = dictionary.childLetters( parentIdx );
+			const uint32_t bit = letters[lane];
+			if ( !(choices & bit) )
+			{
+				continue;
+			}
+			const int dawgIdx = DAWG_CHILD(dawg, parentIdx) + __builtin_popcount( choices & (bit - 1) );
+			const int id = dictionary.rankStep( parentIdx, parentRank[lane], dawgIdx );
+			node[lane] = dawgIdx;
+			rank[lane] = id;
+			if ( depth >= 2 && DAWG_END_OF_WORD(dawg, dawgIdx) )
+			{
+				report( lane, id );
+			}
+			growing |= dictionary.childLetters( dawgIdx ) ? uint32_t(1) << lane : 0;
+		}
+	}
+	if ( !growing || depth + 1 >= MAX_DEPTH )
+	{
+		return;
+	}
+
+	visited[cell] = 1;
+	for ( const int* next = topology.neighbors( cell ); next != topology.neighborsEnd( cell ); ++next )
+	{
+		if ( !visited[*next] )
+		{
+			extend( depth + 1, *next, growing );
+		}
+	}
+	visited[cell] = 0;
+}
+
+void BatchSolver::report( int lane, int rank )
+{
+	uint64_t& word = seen[lane][rank / 64];
+	const uint64_t mask = uint64_t(1) << (rank % 64);
+	if ( !(word & mask) )
+	{
+		word |= mask;
+		results[firstResult + lane].push_back( rank );
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef _BATCHSOLVER_H
+#define _BATCHSOLVER_H
+
+#include "Dictionary.h"
+#include "Topology.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Solves many boards of one size at once, for bulk jobs like rating boards
+//   offline. Every board of a batch is walked along the same sequence of
+//   cell paths, one lane per board, so the recursion, the neighbor lists and
+//   the visited set are shared. Each lane only carries its own DAWG node and
+//   word id. A lane drops out of a path once its board's letters leave the
+//   DAWG, and a path is only extended while some lane is still live.
+//
+// This is a lockstep batch, scalar per lane: no vector instructions are
+//   used, since each lane's step is a gather from the node arrays. Lanes
+//   are stored as structure-of-arrays: the letters of every lane for a
+//   cell, and the DAWG node and id of every lane at a depth, are adjacent.
+//   A child is found with Dictionary::childLetters instead of a sibling
+//   scan, so every lane steps in constant time.
+//
+// The words are the same as WordHeroSolver::solve() reports for each board
+//   with no overlays or constraints. Boards are uppercase letters, row by
+//   row; any other character matches nothing.
+class BatchSolver
+{
+public:
+	static const int LANES = 16;
+
+	BatchSolver( const Dictionary& dictionary, int NRows = 4, int NCols = 4 );
+	// Boards laid out on another topology (see WordHeroSolver::setTopology).
+	BatchSolver( const Dictionary& dictionary, const Topology& topology );
+
+	// Solves every board, LANES at a time.
+	void solve( const std::vector<std::string>& boards );
+
+	int size() const { return results.size(); }
+	// Dictionary ids of a board's words, in ascending (alphabetical) order.
+	const std::vector<int>& wordIds( int board ) const { return results[board]; }
+	// A board's words in the order WordHeroSolver iterates them.
+	void words( int board, std::vector<std::string>& out ) const;
+private:
+	// The most letters solve() follows; longer words are not in the DAWG.
+	static const int MAX_DEPTH = 64;
+
+	const Dictionary& dictionary;
+	const int* dawg;
+	// Every board of the batch shares these neighbor lists.
+	Topology topology;
+	// letterBits[cell*LANES + lane] is bit (c - 'A') for the letter c of that
+	//   lane's board at that cell, or 0.
+	std::vector<uint32_t> letterBits;
+	std::vector<char> visited;
+	int nodes[MAX_DEPTH][LANES];
+	int ranks[MAX_DEPTH][LANES];
+	// One bit per dictionary word per lane, for the words found so far.
+	std::vector<uint64_t> seen[LANES];
+	std::vector<std::vector<int> > results;
+	int firstResult;
+
+	BatchSolver( const BatchSolver& ) = delete;
+	BatchSolver& operator=( const BatchSolver& ) = delete;
+
+	void solveLanes( const std::vector<std::string>& boards, int first, int count );
+	void extend( int depth, int cell, uint32_t live );
+	void report( int lane, int rank );
+};
+
+#endif
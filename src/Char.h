@@ -1,22 +1,32 @@
-
-
 #ifndef _CHAR_H
 #define _CHAR_H
 
+#include <stdint.h>
+
 class Char
 {
 private:
 	bool visited;
 	char character;
+	uint32_t letters;
 public:
-	Char() : visited(true),character(-1) {}
-	Char( char theCharValue ) : visited(false), character(theCharValue) {}
+	// A board cell that may stand for any letter of its set.
+	static const char WILDCARD = '?';
+
+	Char() : visited(true),character(-1),letters(0) {}
+	Char( char theCharValue ) : visited(false), character(theCharValue), letters(0) {}
+	// Bit (c - 'A') of letterSet is set for each letter c the cell allows.
+	Char( char theCharValue, uint32_t letterSet ) : visited(false), character(theCharValue), letters(letterSet) {}
 
 	bool isVisited() const { return visited; }
 	char getChar() const { return character; }
+	bool isWildcard() const { return character == WILDCARD; }
+	uint32_t letterSet() const { return letters; }
 
 	void setVisited() { visited = true; }
 	void setNotVisited() { visited = false; }
+	// Lets a wildcard stand for one letter while a path goes through it.
+	void setChar( char theCharValue ) { character = theCharValue; }
 };
 
 #endif
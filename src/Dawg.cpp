@@ -0,0 +1,48 @@
+
+#include "Dawg.h"
+#include <fstream>
+#include <cstddef>
+
+
+int* initDawg( const char* file, int* nodeCount )
+{
+	int numberOfNodes, *dawgArray;
+	std::ifstream input( file, std::fstream::binary | std::fstream::in );
+	if ( !input )
+	{
+		return NULL;
+	}
+	input.read( (char*)&numberOfNodes, sizeof(int) );
+	if ( !input || numberOfNodes <= 0 )
+	{
+		return NULL;
+	}
+	dawgArray = new int[numberOfNodes];
+	input.read( (char*)dawgArray, numberOfNodes*sizeof(int) );
+	if ( !input )
+	{
+		delete[] dawgArray;
+		return NULL;
+	}
+	input.close();
+
+	// Every child and next index must name a node, so a walk over a corrupt
+	//   file cannot run off the array: node 0 is the empty list, 1 starts the
+	//   entry list and the last node ends a list.
+	bool isValid = numberOfNodes > 1 && (dawgArray[numberOfNodes-1] & END_OF_LIST_BIT_MASK);
+	for ( int i = 0; i < numberOfNodes && isValid; ++i )
+	{
+		isValid = DAWG_CHILD(dawgArray, i) >= 0 && DAWG_CHILD(dawgArray, i) < numberOfNodes;
+	}
+	if ( !isValid )
+	{
+		delete[] dawgArray;
+		return NULL;
+	}
+
+	if ( nodeCount )
+	{
+		*nodeCount = numberOfNodes;
+	}
+	return dawgArray;
+}
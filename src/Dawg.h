@@ -2,7 +2,7 @@
 #ifndef _DAWG_H
 #define _DAWG_H
 
-#include <fstream>
+#include <cstddef>
 
 // These defs are from http://www.pathcom.com/~vadco/dawg.html
 //  A HUGE thank you goes out to JohnPaul Adamovsky for creating this beast
@@ -15,21 +15,14 @@
 #define DAWG_END_OF_WORD(thearray, theindex) (thearray[theindex]&END_OF_WORD_BIT_MASK)
 #define DAWG_NEXT(thearray, theindex) ((thearray[theindex]&END_OF_LIST_BIT_MASK)? 0: theindex + 1)
 #define DAWG_CHILD(thearray, theindex) (thearray[theindex]>>CHILD_BIT_SHIFT)
+// The letter gaddag.dat uses between a word's reversed start and its end;
+//   must match the builder.
+#define GADDAG_SEPARATOR '>'
 
-int* initDawg( const char* file )
-{
-	int numberOfNodes, *dawgArray;
-	std::ifstream input( file, std::fstream::binary | std::fstream::in );
-	if ( !input )
-	{
-		return NULL;
-	}
-	input.read( (char*)&numberOfNodes, sizeof(int) );
-	dawgArray = new int[numberOfNodes];
-	input.read( (char*)dawgArray, numberOfNodes*sizeof(int) );
-	input.close();
-
-	return dawgArray;
-}
+// Reads dictionary.dat; returns NULL if the file cannot be opened, is
+//   truncated or has a child index past the last node. The caller owns the
+//   array (delete[]). Throws std::bad_alloc if the node count is too large
+//   to allocate.
+int* initDawg( const char* file, int* nodeCount = NULL );
 
 #endif
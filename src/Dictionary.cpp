@@ -0,0 +1,200 @@
+
+#include "Dictionary.h"
+#include "Dawg.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Node 1 is the head of the 'A'-'Z' entry list.
+static const int ENTRY_LIST = 1;
+
+
+Dictionary::Dictionary()
+	: dawg(NULL), gaddagNodes(NULL), numberOfNodes(0), totalWords(0), longestWord(0), nodeChecksum(0)
+{
+	std::fill( entryNodes, entryNodes + 26, 0 );
+	std::fill( gaddagEntryNodes, gaddagEntryNodes + 26, 0 );
+}
+
+Dictionary::~Dictionary()
+{
+	delete[] dawg;
+	delete[] gaddagNodes;
+}
+
+bool Dictionary::load( const char* file )
+{
+	int count = 0;
+	int* loaded = initDawg( file, &count );
+	if ( !loaded )
+	{
+		return false;
+	}
+	delete[] dawg;
+	dawg = loaded;
+	numberOfNodes = count;
+
+	nodeChecksum = 14695981039346656037ULL;
+	const unsigned char* bytes = (const unsigned char*)dawg;
+	for ( size_t i = 0; i < numberOfNodes*sizeof(int); ++i )
+	{
+		nodeChecksum = (nodeChecksum ^ bytes[i]) * 1099511628211ULL;
+	}
+	findEntries( dawg, entryNodes );
+
+	// -1 marks a node whose count is not known yet; the DAWG shares suffixes
+	//   so each node is counted once and reused by every parent.
+	wordCounts.assign( numberOfNodes, -1 );
+	wordCounts[0] = 0;
+	totalWords = countList( ENTRY_LIST );
+
+	maxDepths.assign( numberOfNodes, -1 );
+	maxDepths[0] = 0;
+	letterMasks.assign( numberOfNodes, 0 );
+	uint32_t letters = 0;
+	longestWord = measureList( ENTRY_LIST, letters ) + 1;
+	indexLists();
+	return true;
+}
+
+bool Dictionary::loadGaddag( const char* file )
+{
+	int* loaded = initDawg( file );
+	if ( !loaded )
+	{
+		return false;
+	}
+	delete[] gaddagNodes;
+	gaddagNodes = loaded;
+	findEntries( gaddagNodes, gaddagEntryNodes );
+	return true;
+}
+
+// Fills entries['c'-'A'] with the entry-list node for letter c, or 0.
+void Dictionary::findEntries( const int* nodes, int* entries )
+{
+	std::fill( entries, entries + 26, 0 );
+	for ( int dawgIdx = ENTRY_LIST; dawgIdx; dawgIdx = DAWG_NEXT(nodes, dawgIdx) )
+	{
+		const int c = DAWG_LETTER(nodes, dawgIdx);
+		if ( c >= 'A' && c <= 'Z' )
+		{
+			entries[c - 'A'] = dawgIdx;
+		}
+	}
+}
+
+// Fills childMasks and tailCounts. A child pointer may enter a list past
+//   its start, so both are kept for every tail: walking the node array
+//   backwards sees each node's successor first.
+void Dictionary::indexLists()
+{
+	std::vector<uint32_t> tailLetters( numberOfNodes, 0 );
+	tailCounts.assign( numberOfNodes, 0 );
+	for ( int dawgIdx = numberOfNodes - 1; dawgIdx >= 1; --dawgIdx )
+	{
+		const int c = DAWG_LETTER(dawg, dawgIdx) - 'A';
+		const int next = DAWG_NEXT(dawg, dawgIdx) < numberOfNodes ? DAWG_NEXT(dawg, dawgIdx) : 0;
+		tailLetters[dawgIdx] = (c >= 0 && c < 26 ? uint32_t(1) << c : 0) | (next ? tailLetters[next] : 0);
+		tailCounts[dawgIdx] = std::max( wordCounts[dawgIdx], 0 ) + (next ? tailCounts[next] : 0);
+	}
+	childMasks.assign( numberOfNodes, 0 );
+	for ( int dawgIdx = 1; dawgIdx < numberOfNodes; ++dawgIdx )
+	{
+		childMasks[dawgIdx] = DAWG_CHILD(dawg, dawgIdx) ? tailLetters[DAWG_CHILD(dawg, dawgIdx)] : 0;
+	}
+}
+
+int Dictionary::countList( int listIdx )
+{
+	int total = 0;
+	for ( int dawgIdx = listIdx; dawgIdx; dawgIdx = DAWG_NEXT(dawg, dawgIdx) )
+	{
+		if ( wordCounts[dawgIdx] < 0 )
+		{
+			int below = DAWG_CHILD(dawg, dawgIdx) ? countList( DAWG_CHILD(dawg, dawgIdx) ) : 0;
+			wordCounts[dawgIdx] = below + (DAWG_END_OF_WORD(dawg, dawgIdx) ? 1 : 0);
+		}
+		total += wordCounts[dawgIdx];
+	}
+	return total;
+}
+
+// Returns the largest maxDepths entry on a list and sets letters to every
+//   letter on or below it, filling in the list's nodes.
+int Dictionary::measureList( int listIdx, uint32_t& letters )
+{
+	int deepest = 0;
+	letters = 0;
+	for ( int dawgIdx = listIdx; dawgIdx; dawgIdx = DAWG_NEXT(dawg, dawgIdx) )
+	{
+		if ( maxDepths[dawgIdx] < 0 )
+		{
+			maxDepths[dawgIdx] = DAWG_CHILD(dawg, dawgIdx)
+					? measureList( DAWG_CHILD(dawg, dawgIdx), letterMasks[dawgIdx] ) + 1 : 0;
+		}
+		deepest = std::max( deepest, int(maxDepths[dawgIdx]) );
+		letters |= letterMasks[dawgIdx] | (uint32_t(1) << (DAWG_LETTER(dawg, dawgIdx) - 'A'));
+	}
+	return deepest;
+}
+
+int Dictionary::wordId( const char* word, int length ) const
+{
+	if ( length <= 0 )
+	{
+		return -1;
+	}
+	int rank = 0;
+	int dawgIdx = ENTRY_LIST;
+	for ( int i = 0; i < length; ++i )
+	{
+		// Every sibling that sorts before this letter owns a block of lower ids.
+		while ( dawgIdx && DAWG_LETTER(dawg, dawgIdx) != (unsigned char)word[i] )
+		{
+			rank += wordCounts[dawgIdx];
+			dawgIdx = DAWG_NEXT(dawg, dawgIdx);
+		}
+		if ( !dawgIdx )
+		{
+			return -1;
+		}
+		if ( i+1 < length )
+		{
+			// A prefix that is itself a word comes before all of its extensions.
+			rank += DAWG_END_OF_WORD(dawg, dawgIdx) ? 1 : 0;
+			dawgIdx = DAWG_CHILD(dawg, dawgIdx);
+		}
+	}
+	return DAWG_END_OF_WORD(dawg, dawgIdx) ? rank : -1;
+}
+
+std::string Dictionary::word( int id ) const
+{
+	std::string result;
+	if ( id < 0 || id >= totalWords )
+	{
+		return result;
+	}
+	int dawgIdx = ENTRY_LIST;
+	while ( dawgIdx )
+	{
+		while ( id >= wordCounts[dawgIdx] )
+		{
+			id -= wordCounts[dawgIdx];
+			dawgIdx = DAWG_NEXT(dawg, dawgIdx);
+		}
+		result.push_back( DAWG_LETTER(dawg, dawgIdx) );
+		if ( DAWG_END_OF_WORD(dawg, dawgIdx) )
+		{
+			if ( id == 0 )
+			{
+				break;
+			}
+			id -= 1;
+		}
+		dawgIdx = DAWG_CHILD(dawg, dawgIdx);
+	}
+	return result;
+}
@@ -0,0 +1,111 @@
+
+#ifndef _DICTIONARY_H
+#define _DICTIONARY_H
+
+#include "Dawg.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Owns the DAWG node array loaded from dictionary.dat. A Dictionary is
+//   read-only once loaded, so one instance can be shared by any number of
+//   solvers (and threads) instead of each solver loading its own copy.
+//
+// Every word also has a dense id on [0,numberOfWords()): its rank in DAWG
+//   order, which is alphabetical because every DAWG list is sorted. Ids are
+//   computed from per-node word counts, so they cost no extra storage per
+//   word and can stand in for the word's text.
+class Dictionary
+{
+public:
+	Dictionary();
+	~Dictionary();
+
+	bool load( const char* file );
+
+	const int* nodes() const { return dawg; }
+	int size() const { return numberOfNodes; }
+
+	int numberOfWords() const { return totalWords; }
+	// The entry-list node of a first letter, or 0 if no word starts with it.
+	//   The full dictionary has 'A'-'Z' on [1,26], but the builder leaves out
+	//   letters that start no word, so a small themed list may not.
+	int entryNode( char c ) const { return c >= 'A' && c <= 'Z' ? entryNodes[c - 'A'] : 0; }
+	// 64-bit FNV-1a of the node array; identifies a dictionary build in
+	//   anything persisted by word id.
+	uint64_t checksum() const { return nodeChecksum; }
+	// Returns -1 when the word is not in the dictionary.
+	int wordId( const char* word, int length ) const;
+	std::string word( int id ) const;
+	// Number of words at or below a DAWG node (the node's own word included).
+	int wordsBelow( int dawgIdx ) const { return wordCounts[dawgIdx]; }
+	// Most letters any word can still add after a DAWG node; the builder's
+	//   MaxChildDepth, which dictionary.dat does not store. 0 for leaves.
+	int maxDepthBelow( int dawgIdx ) const { return maxDepths[dawgIdx]; }
+	// Bit (c - 'A') is set if letter c appears anywhere below a DAWG node.
+	uint32_t lettersBelow( int dawgIdx ) const { return letterMasks[dawgIdx]; }
+	// Length of the longest word.
+	int maxWordLength() const { return longestWord; }
+	// Bit (c - 'A') is set if letter c is on a node's child list. Lists are
+	//   sorted and contiguous, so the child for letter c is found without a
+	//   scan: DAWG_CHILD plus the number of lower bits set.
+	uint32_t childLetters( int dawgIdx ) const { return childMasks[dawgIdx]; }
+	// Words at or below a node and the nodes after it on its list.
+	int wordsFrom( int dawgIdx ) const { return tailCounts[dawgIdx]; }
+	// The first id at or below dawgIdx, for searches that step down the DAWG
+	//   one letter at a time: parentRank is the same for parentIdx, the node
+	//   dawgIdx is a child of, or parentIdx is 0 for the entry list. Lists
+	//   share their tails, so the id is found by difference of wordsFrom.
+	int rankStep( int parentIdx, int parentRank, int dawgIdx ) const
+	{
+		if ( !parentIdx )
+		{
+			return totalWords - tailCounts[dawgIdx];
+		}
+		// A prefix that is itself a word sorts before all of its extensions,
+		//   and every earlier sibling owns a block of smaller ids.
+		return parentRank + (DAWG_END_OF_WORD(dawg, parentIdx) ? 1 : 0)
+				+ tailCounts[DAWG_CHILD(dawg, parentIdx)] - tailCounts[dawgIdx];
+	}
+	// Starts loading a node, its child letters and its wordsFrom count into
+	//   the cache, for searches that have other work to do until they are read.
+	void prefetch( int dawgIdx ) const
+	{
+		__builtin_prefetch( dawg + dawgIdx );
+		__builtin_prefetch( &childMasks[dawgIdx] );
+		__builtin_prefetch( &tailCounts[dawgIdx] );
+	}
+
+	// Optionally loads gaddag.dat, a GADDAG of the same word list written by
+	//   the builder's GADDAG mode, for anchor queries (see
+	//   WordHeroSolver::solveThrough). It uses the DAWG node format. NULL
+	//   until loaded.
+	bool loadGaddag( const char* file );
+	const int* gaddag() const { return gaddagNodes; }
+	// entryNode for the GADDAG.
+	int gaddagEntryNode( char c ) const { return c >= 'A' && c <= 'Z' ? gaddagEntryNodes[c - 'A'] : 0; }
+private:
+	int* dawg;
+	int* gaddagNodes;
+	int entryNodes[26];
+	int gaddagEntryNodes[26];
+	int numberOfNodes;
+	std::vector<int> wordCounts;
+	std::vector<signed char> maxDepths;
+	std::vector<uint32_t> letterMasks;
+	std::vector<uint32_t> childMasks;
+	std::vector<int> tailCounts;
+	int totalWords;
+	int longestWord;
+	uint64_t nodeChecksum;
+
+	Dictionary( const Dictionary& ) = delete;
+	Dictionary& operator=( const Dictionary& ) = delete;
+
+	int countList( int listIdx );
+	int measureList( int listIdx, uint32_t& letters );
+	void indexLists();
+	static void findEntries( const int* nodes, int* entries );
+};
+
+#endif
@@ -0,0 +1,260 @@
+
+#include "DiskCache.h"
+#include <string>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char MAGIC[4] = { 'W', 'H', 'D', 'C' };
+// Stop inserting when the table is this full, so probes stay short.
+static const double MAX_LOAD = 0.75;
+
+static size_t roundUp( size_t bytes, size_t alignment )
+{
+	return (bytes + alignment - 1) / alignment * alignment;
+}
+
+static uint64_t hashKey( const std::string& key )
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for ( size_t i = 0; i < key.size(); ++i )
+	{
+		hash = (hash ^ (unsigned char)key[i]) * 1099511628211ULL;
+	}
+	// 0 marks an empty bucket.
+	return hash ? hash : 1;
+}
+
+static void putVarint( std::string& out, uint64_t value )
+{
+	while ( value >= 0x80 )
+	{
+		out += char((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+	out += char(value);
+}
+
+static bool getVarint( const char*& in, const char* end, uint64_t& value )
+{
+	value = 0;
+	for ( int shift = 0; in < end && shift < 64; shift += 7 )
+	{
+		const unsigned char byte = *in++;
+		value |= uint64_t(byte & 0x7f) << shift;
+		if ( !(byte & 0x80) )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+DiskCache::DiskCache()
+	: file(NULL), fileBytes(0), header(NULL), table(NULL), data(NULL), hitCount(0), missCount(0)
+{
+}
+
+DiskCache::~DiskCache()
+{
+	if ( file )
+	{
+		munmap( file, fileBytes );
+	}
+}
+
+bool DiskCache::map( int fd, size_t bytes )
+{
+	void* mapped = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	if ( mapped == MAP_FAILED )
+	{
+		return false;
+	}
+	file = (char*)mapped;
+	fileBytes = bytes;
+	header = (DiskCacheHeader*)file;
+	return true;
+}
+
+bool DiskCache::open( const char* path, const Dictionary& dictionary,
+				uint64_t buckets, uint64_t dataBytes )
+{
+	if ( file || buckets == 0 )
+	{
+		return false;
+	}
+	int fd = ::open( path, O_RDWR | O_CREAT, 0644 );
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	struct stat info;
+	if ( fstat( fd, &info ) < 0 )
+	{
+		close( fd );
+		return false;
+	}
+
+	// Reuse the file only if it was written for this exact dictionary and
+	//   its regions fit in it; the sums are checked so they cannot overflow.
+	if ( (size_t)info.st_size >= sizeof(DiskCacheHeader) && map( fd, info.st_size ) )
+	{
+		if ( memcmp( header->magic, MAGIC, sizeof(MAGIC) ) == 0
+			&& header->version == VERSION
+			&& header->dictionaryChecksum == dictionary.checksum()
+			&& header->bucketsAt >= sizeof(DiskCacheHeader) && header->bucketsAt % 64 == 0
+			&& header->dataAt >= header->bucketsAt && header->dataAt <= (uint64_t)info.st_size
+			&& header->dataBytes == (uint64_t)info.st_size - header->dataAt
+			&& header->buckets > 0
+			&& header->buckets <= (header->dataAt - header->bucketsAt) / sizeof(DiskCacheBucket)
+			&& header->dataUsed.load( std::memory_order_relaxed ) <= header->dataBytes )
+		{
+			close( fd );
+			table = (DiskCacheBucket*)(file + header->bucketsAt);
+			data = file + header->dataAt;
+			return true;
+		}
+		munmap( file, fileBytes );
+		file = NULL;
+		header = NULL;
+	}
+
+	const uint64_t bucketsAt = roundUp( sizeof(DiskCacheHeader), 64 );
+	const uint64_t dataAt = roundUp( bucketsAt + buckets*sizeof(DiskCacheBucket), 4096 );
+	// Truncating to 0 first drops every stale page; the new file is sparse.
+	if ( ftruncate( fd, 0 ) < 0 || ftruncate( fd, dataAt + dataBytes ) < 0
+		|| !map( fd, dataAt + dataBytes ) )
+	{
+		close( fd );
+		return false;
+	}
+	close( fd );
+
+	header = new (file) DiskCacheHeader;
+	header->version = VERSION;
+	header->dictionaryChecksum = dictionary.checksum();
+	header->buckets = buckets;
+	header->bucketsAt = bucketsAt;
+	header->dataAt = dataAt;
+	header->dataBytes = dataBytes;
+	header->dataUsed = 0;
+	header->entries = 0;
+	table = (DiskCacheBucket*)(file + bucketsAt);
+	data = file + dataAt;
+	// Written last, so a crash while creating leaves a file that is rebuilt.
+	memcpy( header->magic, MAGIC, sizeof(MAGIC) );
+	return true;
+}
+
+// A bucket whose blob does not lie in the data region never matches, so
+//   a corrupt file turns into misses rather than reads past the mapping.
+bool DiskCache::keyMatches( const DiskCacheBucket& bucket, const std::string& key ) const
+{
+	if ( bucket.offset > header->dataBytes || bucket.length > header->dataBytes - bucket.offset )
+	{
+		return false;
+	}
+	const char* in = data + bucket.offset;
+	const char* end = in + bucket.length;
+	uint64_t keyLength;
+	return getVarint( in, end, keyLength ) && keyLength == key.size()
+		&& uint64_t(end - in) >= keyLength && memcmp( in, key.data(), keyLength ) == 0;
+}
+
+bool DiskCache::lookup( const std::string& key, std::vector<uint32_t>& ids )
+{
+	if ( !file )
+	{
+		return false;
+	}
+	const uint64_t hash = hashKey( key );
+	for ( uint64_t probe = 0, i = hash % header->buckets; probe < header->buckets; ++probe )
+	{
+		const DiskCacheBucket& bucket = table[i];
+		const uint64_t found = bucket.hash.load( std::memory_order_acquire );
+		if ( found == 0 )
+		{
+			break;
+		}
+		if ( found == hash && keyMatches( bucket, key ) )
+		{
+			const char* in = data + bucket.offset;
+			const char* end = in + bucket.length;
+			uint64_t value, count, id = 0;
+			getVarint( in, end, value );
+			in += value;
+			if ( !getVarint( in, end, count ) )
+			{
+				break;
+			}
+			ids.clear();
+			for ( uint64_t n = 0; n < count && getVarint( in, end, value ); ++n )
+			{
+				id += value;
+				ids.push_back( id );
+			}
+			hitCount.fetch_add( 1, std::memory_order_relaxed );
+			return true;
+		}
+		i = i + 1 == header->buckets ? 0 : i + 1;
+	}
+	missCount.fetch_add( 1, std::memory_order_relaxed );
+	return false;
+}
+
+bool DiskCache::insert( const std::string& key, const std::vector<uint32_t>& ids )
+{
+	if ( !file )
+	{
+		return false;
+	}
+	std::string blob;
+	putVarint( blob, key.size() );
+	blob += key;
+	putVarint( blob, ids.size() );
+	uint32_t previous = 0;
+	for ( size_t i = 0; i < ids.size(); ++i )
+	{
+		putVarint( blob, ids[i] - previous );
+		previous = ids[i];
+	}
+
+	std::lock_guard<std::mutex> lock( insertMutex );
+	const uint64_t used = header->dataUsed.load( std::memory_order_relaxed );
+	if ( header->entries.load( std::memory_order_relaxed ) + 1 > MAX_LOAD * header->buckets
+		|| used + blob.size() > header->dataBytes )
+	{
+		return false;
+	}
+	const uint64_t hash = hashKey( key );
+	uint64_t i = hash % header->buckets, probe = 0;
+	for ( ; probe < header->buckets; ++probe, i = i + 1 == header->buckets ? 0 : i + 1 )
+	{
+		const uint64_t found = table[i].hash.load( std::memory_order_relaxed );
+		if ( found == 0 )
+		{
+			break;
+		}
+		if ( found == hash && keyMatches( table[i], key ) )
+		{
+			return true;
+		}
+	}
+	// Only a file whose entry count is wrong can have no empty bucket left.
+	if ( probe == header->buckets )
+	{
+		return false;
+	}
+	memcpy( data + used, blob.data(), blob.size() );
+	header->dataUsed.store( used + blob.size(), std::memory_order_relaxed );
+	table[i].offset = used;
+	table[i].length = blob.size();
+	// Publishing the hash makes the bucket visible to lock-free lookups.
+	table[i].hash.store( hash, std::memory_order_release );
+	header->entries.fetch_add( 1, std::memory_order_relaxed );
+	return true;
+}
@@ -0,0 +1,89 @@
+#ifndef _DISKCACHE_H
+#define _DISKCACHE_H
+
+#include "Dictionary.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+// A persistent result cache: a memory-mapped file holding an open-addressing
+//   hash table of boards and a data region of result blobs, so solved boards
+//   survive restarts (see WordHeroSolver::setDiskCache).
+//
+// File layout:
+//   DiskCacheHeader | buckets * DiskCacheBucket | dataBytes of blobs
+//   A bucket holds a 64-bit hash of the board key (0 for empty) and the
+//   offset and length of its blob. A blob is unsigned LEB128 varints:
+//     [key length][key bytes][word count][sorted word id deltas]
+//   The key is kept so a hash collision is never served as a hit.
+//
+// The header records a checksum of the dictionary. A file written with a
+//   different dictionary (or format version) is wiped on open, so stale word
+//   ids are never served, and so is one whose header does not match its
+//   size. A bucket pointing outside the data region is a miss. The file is
+//   created sparse, so untouched buckets and data cost no disk space.
+//
+// Lookups take no lock; a bucket becomes visible only after its blob is
+//   written. Inserts are serialized by a mutex, so one process may have any
+//   number of solver threads on a file, but only one process should write it.
+struct DiskCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t dictionaryChecksum;
+	uint64_t buckets;
+	uint64_t bucketsAt;
+	uint64_t dataAt;
+	uint64_t dataBytes;
+	std::atomic<uint64_t> dataUsed;
+	std::atomic<uint64_t> entries;
+};
+
+struct DiskCacheBucket
+{
+	std::atomic<uint64_t> hash;
+	uint64_t offset;
+	uint32_t length;
+	uint32_t reserved;
+};
+
+class DiskCache
+{
+public:
+	static const uint32_t VERSION = 1;
+
+	DiskCache();
+	~DiskCache();
+
+	bool open( const char* path, const Dictionary& dictionary,
+			uint64_t buckets = uint64_t(1) << 22, uint64_t dataBytes = uint64_t(1) << 30 );
+
+	// key is ResultCache::canonicalKey; ids come back sorted ascending.
+	bool lookup( const std::string& key, std::vector<uint32_t>& ids );
+	// Returns false (and stores nothing) once the table or data region is full.
+	bool insert( const std::string& key, const std::vector<uint32_t>& ids );
+
+	uint64_t hits() const { return hitCount.load( std::memory_order_relaxed ); }
+	uint64_t misses() const { return missCount.load( std::memory_order_relaxed ); }
+	uint64_t entries() const { return header ? header->entries.load( std::memory_order_relaxed ) : 0; }
+	uint64_t bytesUsed() const { return header ? header->dataUsed.load( std::memory_order_relaxed ) : 0; }
+private:
+	char* file;
+	size_t fileBytes;
+	DiskCacheHeader* header;
+	DiskCacheBucket* table;
+	char* data;
+	std::mutex insertMutex;
+	std::atomic<uint64_t> hitCount;
+	std::atomic<uint64_t> missCount;
+
+	DiskCache( const DiskCache& ) = delete;
+	DiskCache& operator=( const DiskCache& ) = delete;
+
+	bool map( int fd, size_t bytes );
+	bool keyMatches( const DiskCacheBucket& bucket, const std::string& key ) const;
+};
+
+#endif
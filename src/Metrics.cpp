@@ -0,0 +1,244 @@
+
+#include "Metrics.h"
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <cstdio>
+
+typedef std::chrono::steady_clock Clock;
+
+
+LatencyHistogram::LatencyHistogram()
+	: total(0), valueSum(0), maxValue(0)
+{
+	for ( int i = 0; i < NUMBER_OF_BUCKETS; ++i )
+	{
+		buckets[i] = 0;
+	}
+}
+
+int LatencyHistogram::bucketIndex( uint64_t value )
+{
+	if ( value < 2*SUB_BUCKETS )
+	{
+		return value;
+	}
+	// Keep the top SUB_BUCKET_BITS+1 bits of the value: the exponent picks the
+	//   row and the remaining bits pick one of SUB_BUCKETS linear buckets.
+	int exponent = 63 - __builtin_clzll( value ) - SUB_BUCKET_BITS;
+	return (exponent + 1)*SUB_BUCKETS + int(value >> exponent) - SUB_BUCKETS;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound( int index )
+{
+	if ( index < 2*SUB_BUCKETS )
+	{
+		return index;
+	}
+	int exponent = index/SUB_BUCKETS - 1;
+	uint64_t subBucket = index%SUB_BUCKETS + SUB_BUCKETS;
+	return ((subBucket + 1) << exponent) - 1;
+}
+
+void LatencyHistogram::record( uint64_t value )
+{
+	buckets[bucketIndex( value )].fetch_add( 1, std::memory_order_relaxed );
+	total.fetch_add( 1, std::memory_order_relaxed );
+	valueSum.fetch_add( value, std::memory_order_relaxed );
+	uint64_t seen = maxValue.load( std::memory_order_relaxed );
+	while ( value > seen && !maxValue.compare_exchange_weak( seen, value, std::memory_order_relaxed ) ) {}
+}
+
+uint64_t LatencyHistogram::percentile( double p ) const
+{
+	const uint64_t n = count();
+	if ( n == 0 )
+	{
+		return 0;
+	}
+	uint64_t rank = uint64_t( p * n + 0.5 );
+	rank = rank < 1 ? 1 : (rank > n ? n : rank);
+	uint64_t seen = 0;
+	for ( int i = 0; i < NUMBER_OF_BUCKETS; ++i )
+	{
+		seen += buckets[i].load( std::memory_order_relaxed );
+		if ( seen >= rank )
+		{
+			uint64_t upper = bucketUpperBound( i );
+			return upper < max() ? upper : max();
+		}
+	}
+	return max();
+}
+
+
+SolverMetrics::SolverMetrics()
+	: started(Clock::now()), lastDump(started), boardsAtLastDump(0),
+	  stopping(false), intervalSeconds(0), dumpTo(NULL), cache(NULL), diskCache(NULL)
+{
+}
+
+SolverMetrics::~SolverMetrics()
+{
+	stop();
+}
+
+void SolverMetrics::dump( std::ostream& out )
+{
+	const Clock::time_point now = Clock::now();
+	const uint64_t boards = solveNs.count();
+	const double sinceLast = std::chrono::duration<double>( now - lastDump ).count();
+	const double rate = sinceLast > 0 ? (boards - boardsAtLastDump) / sinceLast : 0;
+	lastDump = now;
+	boardsAtLastDump = boards;
+
+	out << std::fixed << std::setprecision( 1 )
+		<< "stats: boards=" << boards << " boards/s=" << rate
+		<< " words/board p50=" << wordsPerBoard.percentile( 0.5 )
+		<< " mean=" << (boards ? double(wordsPerBoard.sum()) / boards : 0.0)
+		<< " solve_us p50=" << solveNs.percentile( 0.5 )/1e3
+		<< " p99=" << solveNs.percentile( 0.99 )/1e3
+		<< " p999=" << solveNs.percentile( 0.999 )/1e3
+		<< " max=" << solveNs.max()/1e3;
+	if ( queueWaitNs.count() )
+	{
+		out << " queue_us p50=" << queueWaitNs.percentile( 0.5 )/1e3
+			<< " p99=" << queueWaitNs.percentile( 0.99 )/1e3;
+	}
+	if ( outputNs.count() )
+	{
+		out << " output_us p50=" << outputNs.percentile( 0.5 )/1e3
+			<< " p99=" << outputNs.percentile( 0.99 )/1e3;
+	}
+	if ( cache )
+	{
+		const uint64_t lookups = cache->hits() + cache->misses();
+		out << " cache hits=" << cache->hits() << " misses=" << cache->misses()
+			<< " hit%=" << (lookups ? 100.0 * cache->hits() / lookups : 0.0)
+			<< " entries=" << cache->entries() << " MB=" << cache->bytes() / 1048576.0;
+	}
+	if ( diskCache )
+	{
+		out << " disk hits=" << diskCache->hits() << " misses=" << diskCache->misses()
+			<< " entries=" << diskCache->entries() << " MB=" << diskCache->bytesUsed() / 1048576.0;
+	}
+	out << std::endl;
+}
+
+static void writeSummary( std::ostream& out, const char* name, const char* help,
+				const LatencyHistogram& histogram, double scale )
+{
+	static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+	out << "# HELP " << name << ' ' << help << '\n'
+		<< "# TYPE " << name << " summary\n";
+	for ( size_t i = 0; i < sizeof(QUANTILES)/sizeof(QUANTILES[0]); ++i )
+	{
+		out << name << "{quantile=\"" << QUANTILES[i] << "\"} "
+			<< histogram.percentile( QUANTILES[i] ) * scale << '\n';
+	}
+	out << name << "_sum " << histogram.sum() * scale << '\n'
+		<< name << "_count " << histogram.count() << '\n';
+}
+
+bool SolverMetrics::writePrometheus( const std::string& path )
+{
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream out( temporary.c_str() );
+		if ( !out )
+		{
+			return false;
+		}
+		const double uptime = std::chrono::duration<double>( Clock::now() - started ).count();
+		out << std::setprecision( 9 );
+		writeSummary( out, "wordhero_solve_seconds", "Time to solve one board.", solveNs, 1e-9 );
+		writeSummary( out, "wordhero_queue_wait_seconds", "Time a board waited for a solver.", queueWaitNs, 1e-9 );
+		writeSummary( out, "wordhero_output_seconds", "Time to encode and write one board's words.", outputNs, 1e-9 );
+		writeSummary( out, "wordhero_words_per_board", "Words found per board.", wordsPerBoard, 1 );
+		out << "# HELP wordhero_boards_total Boards solved since start.\n"
+			<< "# TYPE wordhero_boards_total counter\n"
+			<< "wordhero_boards_total " << solveNs.count() << '\n'
+			<< "# HELP wordhero_boards_per_second Mean boards per second since start.\n"
+			<< "# TYPE wordhero_boards_per_second gauge\n"
+			<< "wordhero_boards_per_second " << (uptime > 0 ? solveNs.count() / uptime : 0) << '\n'
+			<< "# HELP wordhero_uptime_seconds Seconds since the solver started.\n"
+			<< "# TYPE wordhero_uptime_seconds gauge\n"
+			<< "wordhero_uptime_seconds " << uptime << '\n';
+		if ( cache )
+		{
+			out << "# HELP wordhero_cache_hits_total Solves answered from the result cache.\n"
+				<< "# TYPE wordhero_cache_hits_total counter\n"
+				<< "wordhero_cache_hits_total " << cache->hits() << '\n'
+				<< "# HELP wordhero_cache_misses_total Solves the result cache could not answer.\n"
+				<< "# TYPE wordhero_cache_misses_total counter\n"
+				<< "wordhero_cache_misses_total " << cache->misses() << '\n'
+				<< "# HELP wordhero_cache_evictions_total Entries evicted to stay under the memory limit.\n"
+				<< "# TYPE wordhero_cache_evictions_total counter\n"
+				<< "wordhero_cache_evictions_total " << cache->evictions() << '\n'
+				<< "# HELP wordhero_cache_bytes Approximate memory held by the result cache.\n"
+				<< "# TYPE wordhero_cache_bytes gauge\n"
+				<< "wordhero_cache_bytes " << cache->bytes() << '\n';
+		}
+		if ( diskCache )
+		{
+			out << "# HELP wordhero_disk_cache_hits_total Solves answered from the on-disk cache.\n"
+				<< "# TYPE wordhero_disk_cache_hits_total counter\n"
+				<< "wordhero_disk_cache_hits_total " << diskCache->hits() << '\n'
+				<< "# HELP wordhero_disk_cache_misses_total Solves the on-disk cache could not answer.\n"
+				<< "# TYPE wordhero_disk_cache_misses_total counter\n"
+				<< "wordhero_disk_cache_misses_total " << diskCache->misses() << '\n'
+				<< "# HELP wordhero_disk_cache_entries Boards stored in the on-disk cache.\n"
+				<< "# TYPE wordhero_disk_cache_entries gauge\n"
+				<< "wordhero_disk_cache_entries " << diskCache->entries() << '\n';
+		}
+		if ( !out )
+		{
+			return false;
+		}
+	}
+	return rename( temporary.c_str(), path.c_str() ) == 0;
+}
+
+void SolverMetrics::report()
+{
+	if ( dumpTo )
+	{
+		dump( *dumpTo );
+	}
+	if ( !prometheusPath.empty() )
+	{
+		writePrometheus( prometheusPath );
+	}
+}
+
+void SolverMetrics::startReporting( int intervalSeconds, std::ostream* dumpTo, const std::string& prometheusPath )
+{
+	this->intervalSeconds = intervalSeconds < 1 ? 1 : intervalSeconds;
+	this->dumpTo = dumpTo;
+	this->prometheusPath = prometheusPath;
+	stopping = false;
+	reporter = std::thread( [this]()
+	{
+		std::unique_lock<std::mutex> lock( reporterMutex );
+		while ( !reporterWake.wait_for( lock, std::chrono::seconds( this->intervalSeconds ),
+					[this]() { return stopping; } ) )
+		{
+			report();
+		}
+	} );
+}
+
+void SolverMetrics::stop()
+{
+	if ( !reporter.joinable() )
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock( reporterMutex );
+		stopping = true;
+	}
+	reporterWake.notify_all();
+	reporter.join();
+	report();
+}
@@ -0,0 +1,100 @@
+
+#ifndef _METRICS_H
+#define _METRICS_H
+
+#include <atomic>
+#include <string>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <stdint.h>
+#include "ResultCache.h"
+#include "DiskCache.h"
+
+// A log-linear (HDR style) histogram of non-negative integers. Values below
+//   64 are exact; above that every power of two is split into 32 buckets,
+//   so any reported percentile is within ~3% of the true value. Buckets are
+//   atomic, so any number of threads can record() into one histogram.
+class LatencyHistogram
+{
+public:
+	static const int SUB_BUCKET_BITS = 5;
+	static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+	static const int NUMBER_OF_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	LatencyHistogram();
+
+	void record( uint64_t value );
+	uint64_t count() const { return total.load( std::memory_order_relaxed ); }
+	uint64_t sum() const { return valueSum.load( std::memory_order_relaxed ); }
+	uint64_t max() const { return maxValue.load( std::memory_order_relaxed ); }
+	// p is on [0,1]; returns the upper bound of the bucket holding that rank.
+	uint64_t percentile( double p ) const;
+private:
+	std::atomic<uint64_t> buckets[NUMBER_OF_BUCKETS];
+	std::atomic<uint64_t> total;
+	std::atomic<uint64_t> valueSum;
+	std::atomic<uint64_t> maxValue;
+
+	static int bucketIndex( uint64_t value );
+	static uint64_t bucketUpperBound( int index );
+};
+
+// The front end's view of production traffic: per-board solve time, queue
+//   wait and output time (all in nanoseconds), words per board and overall
+//   throughput. Reported as a periodic human-readable dump and/or a
+//   Prometheus text-format file for a local scraper (node_exporter's
+//   textfile collector, for example); there is no network listener.
+class SolverMetrics
+{
+public:
+	SolverMetrics();
+	~SolverMetrics();
+
+	LatencyHistogram solveNs;
+	LatencyHistogram queueWaitNs;
+	LatencyHistogram outputNs;
+	LatencyHistogram wordsPerBoard;
+
+	void recordBoard( uint64_t solveTime, uint64_t wordCount )
+	{
+		solveNs.record( solveTime );
+		wordsPerBoard.record( wordCount );
+	}
+
+	// Also report these caches' hit rates and sizes (NULL for none).
+	void setCache( const ResultCache* cache ) { this->cache = cache; }
+	void setDiskCache( const DiskCache* cache ) { diskCache = cache; }
+
+	void dump( std::ostream& out );
+	// Written to path + ".tmp" and renamed, so a scraper never reads half a file.
+	bool writePrometheus( const std::string& path );
+
+	// Every intervalSeconds, dump to dumpTo (if not NULL) and rewrite the
+	//   Prometheus file (if the path is not empty). stop() does a final report.
+	void startReporting( int intervalSeconds, std::ostream* dumpTo, const std::string& prometheusPath );
+	void stop();
+private:
+	std::chrono::steady_clock::time_point started;
+	std::chrono::steady_clock::time_point lastDump;
+	uint64_t boardsAtLastDump;
+
+	std::thread reporter;
+	std::mutex reporterMutex;
+	std::condition_variable reporterWake;
+	bool stopping;
+	int intervalSeconds;
+	std::ostream* dumpTo;
+	std::string prometheusPath;
+	const ResultCache* cache;
+	const DiskCache* diskCache;
+
+	SolverMetrics( const SolverMetrics& ) = delete;
+	SolverMetrics& operator=( const SolverMetrics& ) = delete;
+
+	void report();
+};
+
+#endif
@@ -0,0 +1,125 @@
+
+#include "ResultCache.h"
+#include <string>
+#include <functional>
+
+// Rough cost of the list node, hash node and string headers of one entry.
+static const size_t ENTRY_OVERHEAD = 128;
+
+
+ResultCache::ResultCache( size_t maxBytes, int numberOfShards )
+	: maxBytes(maxBytes), shards(numberOfShards < 1 ? 1 : numberOfShards),
+	  hitCount(0), missCount(0), evictionCount(0)
+{
+	maxShardBytes = maxBytes / shards.size();
+}
+
+void ResultCache::canonicalKey( const std::string& board, int rows, int cols, std::string& key )
+{
+	key = std::to_string( rows ) + 'x' + std::to_string( cols ) + ':';
+	const size_t prefix = key.size();
+	key += board;
+
+	// Bit 0 flips the rows, bit 1 flips the columns and bit 2 transposes;
+	//   together they make the 8 symmetries of a square. Transposing changes
+	//   a rectangle's shape, so rectangles only get the 4 flips.
+	const int symmetries = rows == cols ? 8 : 4;
+	std::string candidate( board.size(), ' ' );
+	for ( int t = 1; t < symmetries; ++t )
+	{
+		for ( int i = 0; i < rows; ++i )
+		{
+			for ( int j = 0; j < cols; ++j )
+			{
+				int r = (t & 4) ? j : i;
+				int c = (t & 4) ? i : j;
+				r = (t & 1) ? rows-1 - r : r;
+				c = (t & 2) ? cols-1 - c : c;
+				candidate[i*cols + j] = board[r*cols + c];
+			}
+		}
+		if ( key.compare( prefix, std::string::npos, candidate ) > 0 )
+		{
+			key.replace( prefix, std::string::npos, candidate );
+		}
+	}
+}
+
+ResultCache::Shard& ResultCache::shardFor( const std::string& key )
+{
+	return shards[std::hash<std::string>()( key ) % shards.size()];
+}
+
+size_t ResultCache::entryBytes( const Entry& entry )
+{
+	// The key is stored twice: in the entry and in the index.
+	return 2*entry.key.size() + entry.value.size() + ENTRY_OVERHEAD;
+}
+
+bool ResultCache::lookup( const std::string& key, std::string& value )
+{
+	Shard& shard = shardFor( key );
+	std::lock_guard<std::mutex> lock( shard.mutex );
+	std::unordered_map<std::string, std::list<Entry>::iterator>::iterator found = shard.index.find( key );
+	if ( found == shard.index.end() )
+	{
+		missCount.fetch_add( 1, std::memory_order_relaxed );
+		return false;
+	}
+	shard.lru.splice( shard.lru.begin(), shard.lru, found->second );
+	value = found->second->value;
+	hitCount.fetch_add( 1, std::memory_order_relaxed );
+	return true;
+}
+
+void ResultCache::insert( const std::string& key, const std::string& value )
+{
+	Entry entry = { key, value };
+	const size_t bytes = entryBytes( entry );
+	if ( bytes > maxShardBytes )
+	{
+		return;
+	}
+
+	Shard& shard = shardFor( key );
+	std::lock_guard<std::mutex> lock( shard.mutex );
+	std::unordered_map<std::string, std::list<Entry>::iterator>::iterator found = shard.index.find( key );
+	if ( found != shard.index.end() )
+	{
+		// Another solver got here first with the same answer.
+		shard.lru.splice( shard.lru.begin(), shard.lru, found->second );
+		return;
+	}
+	while ( shard.bytes + bytes > maxShardBytes )
+	{
+		shard.bytes -= entryBytes( shard.lru.back() );
+		shard.index.erase( shard.lru.back().key );
+		shard.lru.pop_back();
+		evictionCount.fetch_add( 1, std::memory_order_relaxed );
+	}
+	shard.lru.push_front( entry );
+	shard.index[key] = shard.lru.begin();
+	shard.bytes += bytes;
+}
+
+size_t ResultCache::bytes() const
+{
+	size_t total = 0;
+	for ( size_t i = 0; i < shards.size(); ++i )
+	{
+		std::lock_guard<std::mutex> lock( shards[i].mutex );
+		total += shards[i].bytes;
+	}
+	return total;
+}
+
+size_t ResultCache::entries() const
+{
+	size_t total = 0;
+	for ( size_t i = 0; i < shards.size(); ++i )
+	{
+		std::lock_guard<std::mutex> lock( shards[i].mutex );
+		total += shards[i].index.size();
+	}
+	return total;
+}
@@ -0,0 +1,73 @@
+#ifndef _RESULTCACHE_H
+#define _RESULTCACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+// A thread-safe LRU cache of solved boards, shared by any number of solvers
+//   (see WordHeroSolver::setCache). Rotating or reflecting a board keeps every
+//   adjacency, so it has the same words; boards are therefore keyed by their
+//   canonical form, the smallest of the 8 symmetric layouts of a square grid
+//   (4 for a rectangular one), and all of them share one entry.
+//
+// Entries are split over independently locked shards so concurrent solvers
+//   rarely wait on each other. Each shard evicts its least recently used
+//   entries once it holds more than its share of maxBytes.
+//
+// Every solver sharing a cache must use the same dictionary; the key is only
+//   the board, so solvers with overlays bypass the cache.
+class ResultCache
+{
+public:
+	explicit ResultCache( size_t maxBytes, int numberOfShards = 16 );
+
+	// The key for a rows*cols board: its dimensions and canonical layout.
+	static void canonicalKey( const std::string& board, int rows, int cols, std::string& key );
+
+	// On a hit, copies the cached blob into value.
+	bool lookup( const std::string& key, std::string& value );
+	void insert( const std::string& key, const std::string& value );
+
+	uint64_t hits() const { return hitCount.load( std::memory_order_relaxed ); }
+	uint64_t misses() const { return missCount.load( std::memory_order_relaxed ); }
+	uint64_t evictions() const { return evictionCount.load( std::memory_order_relaxed ); }
+	size_t bytes() const;
+	size_t entries() const;
+	size_t capacity() const { return maxBytes; }
+private:
+	struct Entry
+	{
+		std::string key;
+		std::string value;
+	};
+	struct Shard
+	{
+		mutable std::mutex mutex;
+		// Most recently used first.
+		std::list<Entry> lru;
+		std::unordered_map<std::string, std::list<Entry>::iterator> index;
+		size_t bytes;
+
+		Shard() : bytes(0) {}
+	};
+
+	size_t maxBytes;
+	size_t maxShardBytes;
+	std::vector<Shard> shards;
+	std::atomic<uint64_t> hitCount;
+	std::atomic<uint64_t> missCount;
+	std::atomic<uint64_t> evictionCount;
+
+	ResultCache( const ResultCache& ) = delete;
+	ResultCache& operator=( const ResultCache& ) = delete;
+
+	Shard& shardFor( const std::string& key );
+	static size_t entryBytes( const Entry& entry );
+};
+
+#endif
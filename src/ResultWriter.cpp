@@ -0,0 +1,183 @@
+
+#include "ResultWriter.h"
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+
+static const size_t BUFFER_BYTES = 1 << 16;
+
+
+ResultWriter::ResultWriter( int fd, Format format, const Dictionary& dictionary )
+	: fd(fd), format(format), dictionary(dictionary), buffer(BUFFER_BYTES), used(0), failed(false)
+{
+	if ( format != JSON )
+	{
+		put( "WHR1", 4 );
+		put( char(format) );
+	}
+}
+
+ResultWriter::~ResultWriter()
+{
+	flush();
+}
+
+void ResultWriter::writeBoard( uint64_t boardId, const std::string& input, const WordHeroSolver& solver )
+{
+	WordHeroSolver::const_iterator itr = solver.begin(), end = solver.end();
+	switch ( format )
+	{
+	case BINARY_IDS:
+	{
+		// Sorted ids make every delta small, so most words cost one or two bytes.
+		ids.clear();
+		for ( ; itr != end; ++itr )
+		{
+			int id = dictionary.wordId( itr->data(), itr->size() );
+			if ( id >= 0 )
+			{
+				ids.push_back( id );
+			}
+		}
+		std::sort( ids.begin(), ids.end() );
+		putVarint( boardId );
+		putVarint( ids.size() );
+		uint32_t previous = 0;
+		for ( size_t i = 0; i < ids.size(); ++i )
+		{
+			putVarint( ids[i] - previous );
+			previous = ids[i];
+		}
+		break;
+	}
+	case BINARY_STRINGS:
+		putVarint( boardId );
+		putVarint( std::distance( itr, end ) );
+		for ( ; itr != end; ++itr )
+		{
+			putVarint( itr->size() );
+			put( itr->data(), itr->size() );
+		}
+		break;
+	case JSON:
+	{
+		char number[32];
+		int length = snprintf( number, sizeof(number), "%llu", (unsigned long long)boardId );
+		put( "{\"board\":", 9 );
+		put( number, length );
+		put( ",\"input\":", 9 );
+		putJsonString( input.data(), input.size() );
+		put( ",\"words\":[", 10 );
+		for ( bool first = true; itr != end; ++itr, first = false )
+		{
+			if ( !first )
+			{
+				put( ',' );
+			}
+			putJsonString( itr->data(), itr->size() );
+		}
+		put( ']' );
+		if ( solver.begin() != end && solver.begin().path() )
+		{
+			put( ",\"paths\":[", 10 );
+			itr = solver.begin();
+			for ( bool first = true; itr != end; ++itr, first = false )
+			{
+				if ( !first )
+				{
+					put( ',' );
+				}
+				put( '[' );
+				for ( size_t i = 0; i < itr->size(); ++i )
+				{
+					if ( i )
+					{
+						put( ',' );
+					}
+					length = snprintf( number, sizeof(number), "%u", itr.path()[i] );
+					put( number, length );
+				}
+				put( ']' );
+			}
+			put( ']' );
+		}
+		put( "}\n", 2 );
+		break;
+	}
+	}
+}
+
+bool ResultWriter::flush()
+{
+	size_t written = 0;
+	while ( !failed && written < used )
+	{
+		ssize_t n = write( fd, &buffer[written], used - written );
+		if ( n < 0 && errno == EINTR )
+		{
+			continue;
+		}
+		if ( n <= 0 )
+		{
+			failed = true;
+			break;
+		}
+		written += n;
+	}
+	used = 0;
+	return !failed;
+}
+
+void ResultWriter::put( const char* bytes, size_t length )
+{
+	while ( length )
+	{
+		if ( used == buffer.size() )
+		{
+			flush();
+		}
+		size_t chunk = std::min( length, buffer.size() - used );
+		memcpy( &buffer[used], bytes, chunk );
+		used += chunk;
+		bytes += chunk;
+		length -= chunk;
+	}
+}
+
+void ResultWriter::putVarint( uint64_t value )
+{
+	while ( value >= 0x80 )
+	{
+		put( char((value & 0x7F) | 0x80) );
+		value >>= 7;
+	}
+	put( char(value) );
+}
+
+void ResultWriter::putJsonString( const char* text, size_t length )
+{
+	put( '"' );
+	for ( size_t i = 0; i < length; ++i )
+	{
+		unsigned char c = text[i];
+		if ( c == '"' || c == '\\' )
+		{
+			put( '\\' );
+			put( char(c) );
+		}
+		else if ( c < 0x20 )
+		{
+			char escaped[8];
+			snprintf( escaped, sizeof(escaped), "\\u%04x", c );
+			put( escaped, 6 );
+		}
+		else
+		{
+			put( char(c) );
+		}
+	}
+	put( '"' );
+}
@@ -0,0 +1,54 @@
+
+#ifndef _RESULTWRITER_H
+#define _RESULTWRITER_H
+
+#include "WordHeroSolver.h"
+#include "Dictionary.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// Machine-readable result streams for batch use. Output is collected in a
+//   large buffer and handed to write(2) in big chunks instead of going through
+//   iostreams a word at a time.
+//
+// The binary stream starts with the 4 bytes "WHR1" and one format byte
+//   (BINARY_IDS or BINARY_STRINGS). Each board is then one record of unsigned
+//   LEB128 varints:
+//     [board id][word count][words...]
+//   BINARY_IDS:     each word is its Dictionary id minus the previous id
+//                   (ids are sorted ascending, the first delta is from 0).
+//   BINARY_STRINGS: each word is [length][letters].
+// JSON writes one object per line: {"board":0,"input":"...","words":[...]}
+//   When the solver records paths, "paths":[[cell,...],...] follows "words",
+//   one cell list per word in the same order.
+class ResultWriter
+{
+public:
+	enum Format { BINARY_IDS = 0, BINARY_STRINGS = 1, JSON = 2 };
+
+	ResultWriter( int fd, Format format, const Dictionary& dictionary );
+	~ResultWriter();
+
+	void writeBoard( uint64_t boardId, const std::string& input, const WordHeroSolver& solver );
+	// Returns false once a write to the fd has failed.
+	bool flush();
+private:
+	int fd;
+	Format format;
+	const Dictionary& dictionary;
+	std::vector<char> buffer;
+	size_t used;
+	bool failed;
+	std::vector<uint32_t> ids;
+
+	ResultWriter( const ResultWriter& ) = delete;
+	ResultWriter& operator=( const ResultWriter& ) = delete;
+
+	void put( const char* bytes, size_t length );
+	void put( char byte ) { if ( used == buffer.size() ) flush(); buffer[used++] = byte; }
+	void putVarint( uint64_t value );
+	void putJsonString( const char* text, size_t length );
+};
+
+#endif
@@ -0,0 +1,334 @@
+
+#include "ShmTransport.h"
+#include "WordHeroSolver.h"
+#include <string>
+#include <cstring>
+#include <new>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+// Busy-poll this many empty checks before sleeping on the futex.
+static const int SPINS_BEFORE_WAIT = 1 << 14;
+// Longest futex sleep, so that stop() from another thread is noticed.
+static const int WAIT_MILLISECONDS = 50;
+
+// The segment is shared between processes, so these are not the
+//   FUTEX_PRIVATE_FLAG forms.
+static void futexWait( std::atomic<uint32_t>* word, uint32_t expected, int milliseconds )
+{
+	struct timespec timeout = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+	syscall( SYS_futex, (uint32_t*)word, FUTEX_WAIT, expected, &timeout, NULL, 0 );
+}
+
+static void futexWake( std::atomic<uint32_t>* word )
+{
+	syscall( SYS_futex, (uint32_t*)word, FUTEX_WAKE, 1, NULL, NULL, 0 );
+}
+
+// Wakes the server if it is sleeping. The fence orders the caller's ring
+//   update before the read of serverWaiting, pairing with the fence in
+//   ShmSolverServer::run, so either the server sees the update or this
+//   sees it waiting.
+static void wakeServer( ShmHeader* header )
+{
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	if ( header->serverWaiting.load( std::memory_order_relaxed ) && header->serverWaiting.exchange( 0 ) )
+	{
+		futexWake( &header->serverWaiting );
+	}
+}
+
+static size_t roundUp( size_t bytes, size_t alignment )
+{
+	return (bytes + alignment - 1) / alignment * alignment;
+}
+
+
+ShmSolverServer::ShmSolverServer( const Dictionary& dictionary, int NRows, int NCols,
+				int slots, int maxWords )
+	: dictionary(dictionary), nRows(NRows), nCols(NCols), topology(NULL), bannedWords(NULL), slots(1), maxWords(maxWords),
+	  segment(NULL), segmentBytes(0), running(false)
+{
+	// The ring indices wrap with a mask, so the slot count is a power of two.
+	while ( this->slots < (uint32_t)slots )
+	{
+		this->slots <<= 1;
+	}
+	segmentName[0] = '\0';
+}
+
+ShmSolverServer::~ShmSolverServer()
+{
+	if ( segment )
+	{
+		munmap( segment, segmentBytes );
+		shm_unlink( segmentName );
+	}
+}
+
+bool ShmSolverServer::create( const char* name )
+{
+	if ( segment || strlen( name ) >= sizeof(segmentName) )
+	{
+		return false;
+	}
+
+	const uint32_t numberOfWords = dictionary.numberOfWords();
+	std::string strings;
+	std::vector<uint32_t> offsets( numberOfWords + 1 );
+	for ( uint32_t id = 0; id < numberOfWords; ++id )
+	{
+		offsets[id] = strings.size();
+		strings += dictionary.word( id );
+	}
+	offsets[numberOfWords] = strings.size();
+
+	const uint32_t requestSlotBytes = roundUp( sizeof(ShmRequest) + nRows*nCols, 64 );
+	const uint32_t responseSlotBytes = roundUp( sizeof(ShmResponse) + maxWords*sizeof(uint32_t), 64 );
+	const uint64_t offsetsAt = roundUp( sizeof(ShmHeader), 64 );
+	const uint64_t stringsAt = roundUp( offsetsAt + offsets.size()*sizeof(uint32_t), 64 );
+	const uint64_t requestsAt = roundUp( stringsAt + strings.size(), 64 );
+	const uint64_t responsesAt = requestsAt + uint64_t(slots)*requestSlotBytes;
+	const uint64_t totalBytes = responsesAt + uint64_t(slots)*responseSlotBytes;
+
+	int fd = shm_open( name, O_CREAT | O_TRUNC | O_RDWR, 0600 );
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	if ( ftruncate( fd, totalBytes ) < 0 )
+	{
+		close( fd );
+		shm_unlink( name );
+		return false;
+	}
+	void* mapped = mmap( NULL, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	close( fd );
+	if ( mapped == MAP_FAILED )
+	{
+		shm_unlink( name );
+		return false;
+	}
+	segment = (char*)mapped;
+	segmentBytes = totalBytes;
+	strcpy( segmentName, name );
+
+	ShmHeader* header = new (segment) ShmHeader;
+	header->version = SHM_VERSION;
+	header->rows = nRows;
+	header->cols = nCols;
+	header->slots = slots;
+	header->maxWords = maxWords;
+	header->numberOfWords = numberOfWords;
+	header->requestSlotBytes = requestSlotBytes;
+	header->responseSlotBytes = responseSlotBytes;
+	header->offsetsAt = offsetsAt;
+	header->stringsAt = stringsAt;
+	header->requestsAt = requestsAt;
+	header->responsesAt = responsesAt;
+	header->totalBytes = totalBytes;
+	header->requests.head = 0;
+	header->requests.tail = 0;
+	header->responses.head = 0;
+	header->responses.tail = 0;
+	header->serverWaiting = 0;
+	memcpy( segment + offsetsAt, &offsets[0], offsets.size()*sizeof(uint32_t) );
+	memcpy( segment + stringsAt, strings.data(), strings.size() );
+	// Clients check the magic last, so they never see a half-built segment.
+	std::atomic_thread_fence( std::memory_order_release );
+	header->magic = SHM_MAGIC;
+	return true;
+}
+
+bool ShmSolverServer::setTopology( const Topology* topology )
+{
+	if ( topology && topology->cells() != nRows*nCols )
+	{
+		return false;
+	}
+	this->topology = topology;
+	return true;
+}
+
+void ShmSolverServer::run()
+{
+	if ( !segment )
+	{
+		return;
+	}
+	ShmHeader* header = (ShmHeader*)segment;
+	WordHeroSolver solver( dictionary, nRows, nCols );
+	solver.setTopology( topology );
+	solver.setOverlay( NULL, bannedWords );
+	const uint32_t boardSize = nRows*nCols;
+	const uint64_t mask = slots - 1;
+	std::string board;
+	int idle = 0;
+
+	running = true;
+	while ( running )
+	{
+		const uint64_t requestTail = header->requests.tail.load( std::memory_order_relaxed );
+		const uint64_t responseHead = header->responses.head.load( std::memory_order_relaxed );
+		if ( requestTail == header->requests.head.load( std::memory_order_acquire )
+			|| responseHead - header->responses.tail.load( std::memory_order_acquire ) >= slots )
+		{
+			// Nothing to do, or the client has not drained its answers yet.
+			//   After a short spin, announce the sleep and check again, so
+			//   a submit or release that raced with the announcement is
+			//   either seen here or wakes the futex.
+			if ( ++idle >= SPINS_BEFORE_WAIT )
+			{
+				header->serverWaiting.store( 1 );
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+				if ( requestTail == header->requests.head.load( std::memory_order_acquire )
+					|| responseHead - header->responses.tail.load( std::memory_order_acquire ) >= slots )
+				{
+					futexWait( &header->serverWaiting, 1, WAIT_MILLISECONDS );
+				}
+				header->serverWaiting.store( 0 );
+				idle = 0;
+			}
+			continue;
+		}
+		idle = 0;
+
+		const ShmRequest* request = (const ShmRequest*)(segment + header->requestsAt
+						+ (requestTail & mask)*header->requestSlotBytes);
+		ShmResponse* response = (ShmResponse*)(segment + header->responsesAt
+						+ (responseHead & mask)*header->responseSlotBytes);
+		uint32_t* ids = (uint32_t*)(response + 1);
+
+		response->requestId = request->requestId;
+		response->count = 0;
+		board.assign( (const char*)(request + 1), request->length < boardSize ? request->length : boardSize );
+		const bool isValid = request->length == boardSize && WordHeroSolver::countCells( board ) == int(boardSize);
+		// The request slot is copied out, so hand it back to the client early.
+		header->requests.tail.store( requestTail + 1, std::memory_order_release );
+
+		if ( isValid )
+		{
+			response->status = SHM_OK;
+			WordSpan words = solver.solveView( board.data(), board.size() );
+			for ( const WordView* itr = words.begin(); itr != words.end(); ++itr )
+			{
+				if ( response->count == maxWords )
+				{
+					response->status = SHM_TRUNCATED;
+					break;
+				}
+				ids[response->count++] = dictionary.wordId( itr->data(), itr->size() );
+			}
+		}
+		else
+		{
+			response->status = SHM_BAD_REQUEST;
+		}
+		header->responses.head.store( responseHead + 1, std::memory_order_release );
+	}
+}
+
+void ShmSolverServer::stop()
+{
+	running = false;
+}
+
+
+ShmSolverClient::ShmSolverClient()
+	: segment(NULL), segmentBytes(0), header(NULL)
+{
+}
+
+ShmSolverClient::~ShmSolverClient()
+{
+	if ( segment )
+	{
+		munmap( segment, segmentBytes );
+	}
+}
+
+bool ShmSolverClient::open( const char* name )
+{
+	int fd = shm_open( name, O_RDWR, 0 );
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	struct stat info;
+	if ( fstat( fd, &info ) < 0 || (size_t)info.st_size < sizeof(ShmHeader) )
+	{
+		close( fd );
+		return false;
+	}
+	void* mapped = mmap( NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	close( fd );
+	if ( mapped == MAP_FAILED )
+	{
+		return false;
+	}
+	ShmHeader* candidate = (ShmHeader*)mapped;
+	std::atomic_thread_fence( std::memory_order_acquire );
+	if ( candidate->magic != SHM_MAGIC || candidate->version != SHM_VERSION
+		|| candidate->totalBytes != (uint64_t)info.st_size )
+	{
+		munmap( mapped, info.st_size );
+		return false;
+	}
+	segment = (char*)mapped;
+	segmentBytes = info.st_size;
+	header = candidate;
+	return true;
+}
+
+bool ShmSolverClient::submit( uint64_t requestId, const char* board, size_t length )
+{
+	const uint64_t head = header->requests.head.load( std::memory_order_relaxed );
+	if ( length > header->rows*header->cols
+		|| head - header->requests.tail.load( std::memory_order_acquire ) >= header->slots )
+	{
+		return false;
+	}
+	ShmRequest* request = (ShmRequest*)(segment + header->requestsAt
+					+ (head & (header->slots - 1))*header->requestSlotBytes);
+	request->requestId = requestId;
+	request->length = length;
+	memcpy( request + 1, board, length );
+	header->requests.head.store( head + 1, std::memory_order_release );
+	wakeServer( header );
+	return true;
+}
+
+const ShmResponse* ShmSolverClient::poll() const
+{
+	const uint64_t tail = header->responses.tail.load( std::memory_order_relaxed );
+	if ( tail == header->responses.head.load( std::memory_order_acquire ) )
+	{
+		return NULL;
+	}
+	return (const ShmResponse*)(segment + header->responsesAt
+					+ (tail & (header->slots - 1))*header->responseSlotBytes);
+}
+
+void ShmSolverClient::release()
+{
+	const uint64_t tail = header->responses.tail.load( std::memory_order_relaxed );
+	header->responses.tail.store( tail + 1, std::memory_order_release );
+	wakeServer( header );
+}
+
+const char* ShmSolverClient::word( uint32_t id, int* length ) const
+{
+	const uint32_t* offsets = (const uint32_t*)(segment + header->offsetsAt);
+	if ( id >= header->numberOfWords )
+	{
+		*length = 0;
+		return NULL;
+	}
+	*length = offsets[id+1] - offsets[id];
+	return segment + header->stringsAt + offsets[id];
+}
@@ -0,0 +1,142 @@
+
+#ifndef _SHMTRANSPORT_H
+#define _SHMTRANSPORT_H
+
+#include "Dictionary.h"
+#include "Topology.h"
+#include "Trie.h"
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+// A same-host transport with no syscalls on the request path. The server
+//   creates a POSIX shared memory segment holding:
+//     - the dictionary's string table (word id -> letters),
+//     - a request ring  (client produces boards, server consumes),
+//     - a response ring (server produces word ids, client consumes).
+//   Each ring is lock-free single-producer/single-consumer, so one segment
+//   serves exactly one client. Answers are word ids that the client resolves
+//   in the shared string table without copying any text. An idle server
+//   spins briefly, then sleeps on a futex in the header that the client
+//   wakes; the request path only makes a syscall when the server sleeps.
+enum { SHM_OK = 0, SHM_BAD_REQUEST = 1, SHM_TRUNCATED = 2 };
+
+static const uint32_t SHM_MAGIC = 0x57485348;
+static const uint32_t SHM_VERSION = 2;
+
+struct ShmRing
+{
+	// head is written only by the producer and tail only by the consumer;
+	//   they sit on separate cache lines so the two sides never false-share.
+	alignas(64) std::atomic<uint64_t> head;
+	alignas(64) std::atomic<uint64_t> tail;
+};
+
+struct ShmHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t rows;
+	uint32_t cols;
+	uint32_t slots;
+	uint32_t maxWords;
+	uint32_t numberOfWords;
+	uint32_t requestSlotBytes;
+	uint32_t responseSlotBytes;
+	uint64_t offsetsAt;
+	uint64_t stringsAt;
+	uint64_t requestsAt;
+	uint64_t responsesAt;
+	uint64_t totalBytes;
+	ShmRing requests;
+	ShmRing responses;
+	// 1 while the server sleeps (or is about to) on this futex word; the
+	//   client clears it and wakes the server after a submit or release.
+	alignas(64) std::atomic<uint32_t> serverWaiting;
+};
+
+struct ShmRequest
+{
+	uint64_t requestId;
+	uint32_t length;
+	uint32_t reserved;
+	// followed by rows*cols board cells: letters or '?' wildcards. The slots
+	//   hold one byte per cell, so bracketed letter sets do not fit.
+};
+
+struct ShmResponse
+{
+	uint64_t requestId;
+	uint32_t status;
+	uint32_t count;
+	// followed by count uint32_t word ids
+};
+
+class ShmSolverServer
+{
+public:
+	ShmSolverServer( const Dictionary& dictionary, int NRows = 4, int NCols = 4,
+				int slots = 64, int maxWords = 4096 );
+	~ShmSolverServer();
+
+	// Creates (or replaces) the named segment, e.g. "/wordhero".
+	bool create( const char* name );
+	// The board layout to solve on (see WordHeroSolver::setTopology).
+	bool setTopology( const Topology* topology );
+	// Words to leave out of every answer. Answers are dictionary word ids,
+	//   so there is no way to add words.
+	void setBanned( const Trie* banned ) { bannedWords = banned; }
+	// Serve until stop() is called. stop() is async-signal-safe; a sleeping
+	//   server notices within 50 ms.
+	void run();
+	void stop();
+private:
+	const Dictionary& dictionary;
+	int nRows;
+	int nCols;
+	const Topology* topology;
+	const Trie* bannedWords;
+	uint32_t slots;
+	uint32_t maxWords;
+	char* segment;
+	size_t segmentBytes;
+	char segmentName[256];
+	std::atomic<bool> running;
+
+	ShmSolverServer( const ShmSolverServer& ) = delete;
+	ShmSolverServer& operator=( const ShmSolverServer& ) = delete;
+};
+
+class ShmSolverClient
+{
+public:
+	ShmSolverClient();
+	~ShmSolverClient();
+
+	bool open( const char* name );
+
+	// Non-blocking; false when the request ring is full or the board does not fit.
+	bool submit( uint64_t requestId, const char* board, size_t length );
+	// The oldest unreleased response, or NULL if none is ready. The response
+	//   stays valid until release() is called.
+	const ShmResponse* poll() const;
+	void release();
+
+	static const uint32_t* wordIds( const ShmResponse* response )
+	{
+		return (const uint32_t*)(response + 1);
+	}
+	// Points into the shared string table; the letters are not NUL terminated.
+	const char* word( uint32_t id, int* length ) const;
+	int rows() const { return header ? header->rows : 0; }
+	int cols() const { return header ? header->cols : 0; }
+private:
+	char* segment;
+	size_t segmentBytes;
+	ShmHeader* header;
+
+	ShmSolverClient( const ShmSolverClient& ) = delete;
+	ShmSolverClient& operator=( const ShmSolverClient& ) = delete;
+};
+
+#endif
@@ -0,0 +1,60 @@
+
+#ifndef _SOLVERCOUNTERS_H
+#define _SOLVERCOUNTERS_H
+
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+
+// Hot-path instrumentation for the search engines. Build with
+//   -DWORDHERO_COUNTERS (make COUNTERS=1) to collect; otherwise every
+//   SOLVER_COUNT() statement is removed by the preprocessor and the search
+//   runs exactly as before.
+//
+// The board engine (solvehelper) fills every counter. The frontier and
+//   interleaved engines find children with a letter mask, not a list scan,
+//   and do not search one start cell at a time, so they leave the sibling
+//   scans and startCellNs at zero. The frontier engine counts the states it
+//   creates as nodes, and only the visited neighbors that hold a next
+//   letter. The dictionary engine only counts words.
+#ifdef WORDHERO_COUNTERS
+#define SOLVER_COUNT(statement) do { statement; } while ( 0 )
+#else
+#define SOLVER_COUNT(statement) do { } while ( 0 )
+#endif
+
+struct SolverCounters
+{
+#ifdef WORDHERO_COUNTERS
+	static const bool enabled = true;
+#else
+	static const bool enabled = false;
+#endif
+	// Longer DAWG sibling scans and deeper prunes land in the last bucket.
+	static const int MAX_SCAN = 32;
+	static const int MAX_DEPTH = 32;
+
+	uint64_t nodesExpanded;                 // cells appended to a prefix (frontier: states)
+	uint64_t visitedRejects;                // neighbours already on the path
+	uint64_t siblingScans;                  // DAWG child lists searched
+	uint64_t siblingSteps;                  // list entries inspected in total
+	uint64_t scanLengths[MAX_SCAN];         // histogram of entries per scan
+	uint64_t pruneDepths[MAX_DEPTH];        // prefix length when a branch died
+	uint64_t wordsFound;                    // unique words
+	uint64_t duplicateHits;                 // words reached again by another path
+	std::vector<uint64_t> startCellNs;      // time spent below each start cell
+
+	SolverCounters() { reset( 0 ); }
+
+	void reset( int numberOfCells )
+	{
+		nodesExpanded = visitedRejects = 0;
+		siblingScans = siblingSteps = 0;
+		memset( scanLengths, 0, sizeof(scanLengths) );
+		memset( pruneDepths, 0, sizeof(pruneDepths) );
+		wordsFound = duplicateHits = 0;
+		startCellNs.assign( numberOfCells, 0 );
+	}
+};
+
+#endif
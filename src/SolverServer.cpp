@@ -0,0 +1,549 @@
+
+#include "SolverServer.h"
+#include "WordHeroSolver.h"
+#include <string>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+typedef std::chrono::steady_clock Clock;
+
+// A request larger than any sane board is treated as a protocol error.
+static const uint32_t MAX_REQUEST_LENGTH = 1 << 16;
+
+static void appendU32( std::string& out, uint32_t value )
+{
+	char bytes[4] = { char(value >> 24), char(value >> 16), char(value >> 8), char(value) };
+	out.append( bytes, 4 );
+}
+static uint32_t readU32( const char* bytes )
+{
+	const unsigned char* b = (const unsigned char*)bytes;
+	return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+}
+static uint64_t nanosecondsBetween( Clock::time_point from, Clock::time_point to )
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>( to - from ).count();
+}
+// Appends [length][letters] for each word and returns how many there were.
+template <typename Iterator>
+static uint32_t appendWords( std::string& out, Iterator itr, Iterator end )
+{
+	uint32_t count = 0;
+	for ( ; itr != end; ++itr, ++count )
+	{
+		out.push_back( char(itr->size()) );
+		out.append( itr->data(), itr->size() );
+	}
+	return count;
+}
+
+
+SolverServer::SolverServer( const Dictionary& dictionary, int NRows, int NCols,
+				int numberOfWorkers )
+	: dictionary(dictionary), nRows(NRows), nCols(NCols),
+	  numberOfWorkers(numberOfWorkers < 1 ? 1 : numberOfWorkers),
+	  addedWords(NULL), bannedWords(NULL), topology(NULL), metrics(NULL), cache(NULL), diskCache(NULL), running(false), nextConnectionId(1)
+{
+	epollFd = epoll_create1( 0 );
+	wakeFd = eventfd( 0, EFD_NONBLOCK );
+	if ( epollFd < 0 || wakeFd < 0 )
+	{
+		std::cerr << "could not create the server event loop: " << strerror(errno) << std::endl;
+		exit(1);
+	}
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = wakeFd;
+	epoll_ctl( epollFd, EPOLL_CTL_ADD, wakeFd, &event );
+}
+
+SolverServer::~SolverServer()
+{
+	for ( std::map<uint64_t, Connection>::iterator itr = connections.begin(); itr != connections.end(); ++itr )
+	{
+		close( itr->second.fd );
+	}
+	for ( size_t i = 0; i < listenFds.size(); ++i )
+	{
+		close( listenFds[i] );
+	}
+	if ( !unixPath.empty() )
+	{
+		unlink( unixPath.c_str() );
+	}
+	close( wakeFd );
+	close( epollFd );
+}
+
+void SolverServer::setOverlay( const Trie* added, const Trie* banned )
+{
+	addedWords = added;
+	bannedWords = banned;
+}
+
+bool SolverServer::setTopology( const Topology* topology )
+{
+	if ( topology && topology->cells() != nRows*nCols )
+	{
+		return false;
+	}
+	this->topology = topology;
+	return true;
+}
+
+void SolverServer::setCache( ResultCache* cache )
+{
+	this->cache = cache;
+}
+
+void SolverServer::setDiskCache( DiskCache* cache )
+{
+	diskCache = cache;
+}
+
+void SolverServer::setMetrics( SolverMetrics* metrics )
+{
+	this->metrics = metrics;
+}
+
+bool SolverServer::addListener( int fd )
+{
+	if ( listen( fd, SOMAXCONN ) < 0 )
+	{
+		close( fd );
+		return false;
+	}
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = fd;
+	epoll_ctl( epollFd, EPOLL_CTL_ADD, fd, &event );
+	listenFds.push_back( fd );
+	return true;
+}
+
+bool SolverServer::listenUnix( const char* path )
+{
+	sockaddr_un address;
+	if ( strlen( path ) >= sizeof(address.sun_path) )
+	{
+		return false;
+	}
+	int fd = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	memset( &address, 0, sizeof(address) );
+	address.sun_family = AF_UNIX;
+	strcpy( address.sun_path, path );
+	// A stale socket file from a previous daemon would make bind() fail.
+	unlink( path );
+	if ( bind( fd, (sockaddr*)&address, sizeof(address) ) < 0 )
+	{
+		close( fd );
+		return false;
+	}
+	unixPath = path;
+	return addListener( fd );
+}
+
+bool SolverServer::listenTcp( int port )
+{
+	int fd = socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+	if ( fd < 0 )
+	{
+		return false;
+	}
+	int on = 1;
+	setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on) );
+	sockaddr_in address;
+	memset( &address, 0, sizeof(address) );
+	address.sin_family = AF_INET;
+	address.sin_port = htons( port );
+	// Localhost only; the daemon is not meant to be exposed to the network.
+	address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+	if ( bind( fd, (sockaddr*)&address, sizeof(address) ) < 0 )
+	{
+		close( fd );
+		return false;
+	}
+	return addListener( fd );
+}
+
+void SolverServer::run()
+{
+	running = true;
+	for ( int i = 0; i < numberOfWorkers; ++i )
+	{
+		workers.push_back( std::thread( &SolverServer::worker, this ) );
+	}
+
+	const int MAX_EVENTS = 64;
+	epoll_event events[MAX_EVENTS];
+	while ( running )
+	{
+		int n = epoll_wait( epollFd, events, MAX_EVENTS, -1 );
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+			{
+				continue;
+			}
+			std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+			break;
+		}
+		for ( int i = 0; i < n; ++i )
+		{
+			int fd = events[i].data.fd;
+			if ( fd == wakeFd )
+			{
+				uint64_t count;
+				while ( read( wakeFd, &count, sizeof(count) ) == sizeof(count) ) {}
+				collectFinished();
+				continue;
+			}
+			bool isListener = false;
+			for ( size_t j = 0; j < listenFds.size(); ++j )
+			{
+				isListener = isListener || listenFds[j] == fd;
+			}
+			if ( isListener )
+			{
+				acceptClients( fd );
+				continue;
+			}
+			std::map<int, uint64_t>::iterator conn = fdToConnection.find( fd );
+			if ( conn == fdToConnection.end() )
+			{
+				continue;
+			}
+			uint64_t connectionId = conn->second;
+			if ( (events[i].events & EPOLLERR)
+				|| ((events[i].events & EPOLLHUP) && connections[connectionId].readClosed) )
+			{
+				closeClient( connectionId );
+				continue;
+			}
+			if ( events[i].events & EPOLLOUT )
+			{
+				writeClient( connectionId );
+			}
+			if ( events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR) )
+			{
+				readClient( connectionId );
+			}
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( jobMutex );
+		running = false;
+	}
+	jobReady.notify_all();
+	for ( size_t i = 0; i < workers.size(); ++i )
+	{
+		workers[i].join();
+	}
+	workers.clear();
+}
+
+void SolverServer::stop()
+{
+	running = false;
+	uint64_t one = 1;
+	ssize_t ignored = write( wakeFd, &one, sizeof(one) );
+	(void)ignored;
+}
+
+void SolverServer::worker()
+{
+	WordHeroSolver solver( dictionary, nRows, nCols );
+	solver.setOverlay( addedWords, bannedWords );
+	solver.setTopology( topology );
+	solver.setCache( cache );
+	solver.setDiskCache( diskCache );
+	const size_t boardSize = nRows*nCols;
+
+	while ( true )
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock( jobMutex );
+			while ( running && jobs.empty() )
+			{
+				jobReady.wait( lock );
+			}
+			if ( !running )
+			{
+				return;
+			}
+			job = std::move( jobs.front() );
+			jobs.pop_front();
+		}
+		const Clock::time_point started = Clock::now();
+		if ( metrics )
+		{
+			metrics->queueWaitNs.record( nanosecondsBetween( job.queued, started ) );
+		}
+
+		const bool isValid = WordHeroSolver::countCells( job.board ) == int(boardSize);
+
+		std::string body;
+		if ( isValid )
+		{
+			// Without caches to fill, the arena-backed solve allocates nothing per word.
+			WordSpan words;
+			if ( cache || diskCache )
+			{
+				solver.solve( job.board );
+			}
+			else
+			{
+				words = solver.solveView( job.board.data(), job.board.size() );
+			}
+			const Clock::time_point solved = Clock::now();
+			body.push_back( char(SERVER_OK) );
+			appendU32( body, 0 );
+			const uint32_t count = cache || diskCache ? appendWords( body, solver.begin(), solver.end() )
+					: appendWords( body, words.begin(), words.end() );
+			body[1] = char(count >> 24);
+			body[2] = char(count >> 16);
+			body[3] = char(count >> 8);
+			body[4] = char(count);
+			if ( metrics )
+			{
+				metrics->recordBoard( nanosecondsBetween( started, solved ), count );
+				metrics->outputNs.record( nanosecondsBetween( solved, Clock::now() ) );
+			}
+		}
+		else
+		{
+			body.push_back( char(SERVER_BAD_REQUEST) );
+			appendU32( body, 0 );
+		}
+		appendU32( job.response, body.size() );
+		job.response.append( body );
+
+		{
+			std::lock_guard<std::mutex> lock( doneMutex );
+			done.push_back( std::move( job ) );
+		}
+		uint64_t one = 1;
+		ssize_t ignored = write( wakeFd, &one, sizeof(one) );
+		(void)ignored;
+	}
+}
+
+void SolverServer::acceptClients( int listenFd )
+{
+	while ( true )
+	{
+		int fd = accept4( listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC );
+		if ( fd < 0 )
+		{
+			return;
+		}
+		uint64_t connectionId = nextConnectionId++;
+		Connection& conn = connections[connectionId];
+		conn.fd = fd;
+		conn.nextSequence = 0;
+		conn.nextToSend = 0;
+		conn.wantsWrite = false;
+		conn.readClosed = false;
+		fdToConnection[fd] = connectionId;
+
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.fd = fd;
+		epoll_ctl( epollFd, EPOLL_CTL_ADD, fd, &event );
+	}
+}
+
+void SolverServer::readClient( uint64_t connectionId )
+{
+	std::map<uint64_t, Connection>::iterator itr = connections.find( connectionId );
+	if ( itr == connections.end() || itr->second.readClosed )
+	{
+		return;
+	}
+	Connection& conn = itr->second;
+
+	char buffer[4096];
+	while ( true )
+	{
+		ssize_t n = read( conn.fd, buffer, sizeof(buffer) );
+		if ( n > 0 )
+		{
+			conn.in.append( buffer, n );
+			continue;
+		}
+		if ( n == 0 )
+		{
+			// Half-closed: keep the connection until every pipelined answer is sent.
+			conn.readClosed = true;
+			updateEvents( conn );
+			break;
+		}
+		if ( errno == EINTR )
+		{
+			continue;
+		}
+		if ( errno != EAGAIN && errno != EWOULDBLOCK )
+		{
+			closeClient( connectionId );
+			return;
+		}
+		break;
+	}
+
+	size_t offset = 0;
+	size_t queued = 0;
+	while ( conn.in.size() - offset >= 4 )
+	{
+		uint32_t length = readU32( conn.in.data() + offset );
+		if ( length > MAX_REQUEST_LENGTH )
+		{
+			closeClient( connectionId );
+			return;
+		}
+		if ( conn.in.size() - offset - 4 < length )
+		{
+			break;
+		}
+		Job job;
+		job.connectionId = connectionId;
+		job.sequence = conn.nextSequence++;
+		job.queued = Clock::now();
+		job.board.assign( conn.in, offset + 4, length );
+		{
+			std::lock_guard<std::mutex> lock( jobMutex );
+			jobs.push_back( std::move( job ) );
+		}
+		offset += 4 + length;
+		queued += 1;
+	}
+	conn.in.erase( 0, offset );
+	if ( queued == 1 )
+	{
+		jobReady.notify_one();
+	}
+	else if ( queued > 1 )
+	{
+		jobReady.notify_all();
+	}
+
+	if ( conn.readClosed && conn.nextToSend == conn.nextSequence && conn.out.empty() )
+	{
+		closeClient( connectionId );
+	}
+}
+
+void SolverServer::writeClient( uint64_t connectionId )
+{
+	std::map<uint64_t, Connection>::iterator itr = connections.find( connectionId );
+	if ( itr == connections.end() )
+	{
+		return;
+	}
+	Connection& conn = itr->second;
+
+	size_t written = 0;
+	while ( written < conn.out.size() )
+	{
+		ssize_t n = send( conn.fd, conn.out.data() + written, conn.out.size() - written, MSG_NOSIGNAL );
+		if ( n > 0 )
+		{
+			written += n;
+			continue;
+		}
+		if ( n < 0 && errno == EINTR )
+		{
+			continue;
+		}
+		if ( n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) )
+		{
+			break;
+		}
+		closeClient( connectionId );
+		return;
+	}
+	conn.out.erase( 0, written );
+
+	bool wantsWrite = !conn.out.empty();
+	if ( wantsWrite != conn.wantsWrite )
+	{
+		conn.wantsWrite = wantsWrite;
+		updateEvents( conn );
+	}
+
+	if ( conn.readClosed && conn.nextToSend == conn.nextSequence && conn.out.empty() )
+	{
+		closeClient( connectionId );
+	}
+}
+
+void SolverServer::updateEvents( Connection& conn )
+{
+	epoll_event event;
+	event.events = (conn.readClosed ? 0 : EPOLLIN) | (conn.wantsWrite ? EPOLLOUT : 0);
+	event.data.fd = conn.fd;
+	epoll_ctl( epollFd, EPOLL_CTL_MOD, conn.fd, &event );
+}
+
+void SolverServer::closeClient( uint64_t connectionId )
+{
+	std::map<uint64_t, Connection>::iterator itr = connections.find( connectionId );
+	if ( itr == connections.end() )
+	{
+		return;
+	}
+	// Closing the fd also removes it from the epoll set. Jobs still in flight
+	//   for this connection are dropped when they finish.
+	close( itr->second.fd );
+	fdToConnection.erase( itr->second.fd );
+	connections.erase( itr );
+}
+
+void SolverServer::collectFinished()
+{
+	std::deque<Job> finished;
+	{
+		std::lock_guard<std::mutex> lock( doneMutex );
+		finished.swap( done );
+	}
+	std::set<uint64_t> touched;
+	for ( size_t i = 0; i < finished.size(); ++i )
+	{
+		std::map<uint64_t, Connection>::iterator itr = connections.find( finished[i].connectionId );
+		if ( itr == connections.end() )
+		{
+			continue;
+		}
+		Connection& conn = itr->second;
+		conn.finished[finished[i].sequence].swap( finished[i].response );
+		// Pipelined requests may finish out of order on different workers;
+		//   only release answers once every earlier one is out.
+		std::map<uint64_t, std::string>::iterator next;
+		while ( (next = conn.finished.find( conn.nextToSend )) != conn.finished.end() )
+		{
+			conn.out.append( next->second );
+			conn.finished.erase( next );
+			conn.nextToSend += 1;
+		}
+		touched.insert( finished[i].connectionId );
+	}
+	for ( std::set<uint64_t>::iterator itr = touched.begin(); itr != touched.end(); ++itr )
+	{
+		writeClient( *itr );
+	}
+}
@@ -0,0 +1,119 @@
+
+#ifndef _SOLVERSERVER_H
+#define _SOLVERSERVER_H
+
+#include "Dictionary.h"
+#include "Trie.h"
+#include "Metrics.h"
+#include "ResultCache.h"
+#include "DiskCache.h"
+#include "Topology.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+
+// A persistent solver daemon. The dictionary and a pool of solvers stay
+//   resident; boards arrive over a Unix domain socket or a localhost TCP port
+//   and are served by an epoll event loop.
+//
+// Protocol (all integers are big-endian uint32):
+//   request:  [length][board]                    rows*cols cells, as solve() reads them
+//   response: [length][status][word count][words]
+//             status is SERVER_OK or SERVER_BAD_REQUEST, and every word is
+//             sent as a one byte length followed by its letters.
+// Clients may pipeline any number of requests on one connection; responses
+//   always come back in request order.
+enum { SERVER_OK = 0, SERVER_BAD_REQUEST = 1 };
+
+class SolverServer
+{
+public:
+	SolverServer( const Dictionary& dictionary, int NRows = 4, int NCols = 4,
+				int numberOfWorkers = 1 );
+	~SolverServer();
+
+	// Overlay tries are shared by every solver in the pool (see WordHeroSolver::setOverlay).
+	void setOverlay( const Trie* added, const Trie* banned );
+	// The board layout of every solver in the pool (see WordHeroSolver::setTopology).
+	bool setTopology( const Topology* topology );
+	// Optional; shared by every solver in the pool (see WordHeroSolver::setCache).
+	void setCache( ResultCache* cache );
+	void setDiskCache( DiskCache* cache );
+	// Optional; records queue wait, solve and encode time for every board.
+	void setMetrics( SolverMetrics* metrics );
+
+	bool listenUnix( const char* path );
+	bool listenTcp( int port );
+
+	// Serve until stop() is called. stop() is async-signal-safe.
+	void run();
+	void stop();
+private:
+	struct Job
+	{
+		uint64_t connectionId;
+		uint64_t sequence;
+		std::chrono::steady_clock::time_point queued;
+		std::string board;
+		std::string response;
+	};
+	struct Connection
+	{
+		int fd;
+		std::string in;
+		std::string out;
+		uint64_t nextSequence;
+		uint64_t nextToSend;
+		std::map<uint64_t, std::string> finished;
+		bool wantsWrite;
+		bool readClosed;
+	};
+
+	const Dictionary& dictionary;
+	int nRows;
+	int nCols;
+	int numberOfWorkers;
+	const Trie* addedWords;
+	const Trie* bannedWords;
+	const Topology* topology;
+	SolverMetrics* metrics;
+	ResultCache* cache;
+	DiskCache* diskCache;
+
+	int epollFd;
+	int wakeFd;
+	std::vector<int> listenFds;
+	std::string unixPath;
+	std::atomic<bool> running;
+
+	std::map<int, uint64_t> fdToConnection;
+	std::map<uint64_t, Connection> connections;
+	uint64_t nextConnectionId;
+
+	std::vector<std::thread> workers;
+	std::mutex jobMutex;
+	std::condition_variable jobReady;
+	std::deque<Job> jobs;
+	std::mutex doneMutex;
+	std::deque<Job> done;
+
+	SolverServer( const SolverServer& ) = delete;
+	SolverServer& operator=( const SolverServer& ) = delete;
+
+	bool addListener( int fd );
+	void worker();
+	void acceptClients( int listenFd );
+	void readClient( uint64_t connectionId );
+	void writeClient( uint64_t connectionId );
+	void updateEvents( Connection& conn );
+	void closeClient( uint64_t connectionId );
+	void collectFinished();
+};
+
+#endif
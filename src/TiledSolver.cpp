@@ -0,0 +1,177 @@
+
+#include "TiledSolver.h"
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <cctype>
+
+// solvehelper finds no longer word, however long an added word is.
+static const int MAX_WORD_LENGTH = 48;
+// Paths are kept as 16-bit cell indices, so a bordered tile may hold at most
+//   this many cells on a side.
+static const int MAX_TILE_SIDE = 256;
+// Stands for the cells past the edge of the grid; it matches no letter.
+static const char OUTSIDE = '.';
+
+
+TiledSolver::TiledSolver( const Dictionary& dictionary, int tileSize, int numberOfThreads )
+	: dictionary(dictionary), addedWords(NULL), bannedWords(NULL),
+	  requestedTileSize(tileSize), numberOfThreads(numberOfThreads < 1 ? 1 : numberOfThreads),
+	  tileSize(0), halo(0), nRows(0), nCols(0), bandTop(0), nextTile(0)
+{
+}
+
+TiledSolver::~TiledSolver()
+{
+	for ( size_t i = 0; i < solvers.size(); ++i )
+	{
+		delete solvers[i];
+	}
+}
+
+void TiledSolver::setOverlay( const Trie* added, const Trie* banned )
+{
+	addedWords = added;
+	bannedWords = banned;
+}
+
+// Sizes the halo for the current word lists and makes one solver per worker
+//   for a bordered tile, reusing the last ones if the size is unchanged.
+void TiledSolver::prepareSolvers()
+{
+	int longest = dictionary.maxWordLength();
+	if ( addedWords )
+	{
+		longest = std::max( longest, addedWords->maxLength() );
+	}
+	halo = std::max( std::min( longest, MAX_WORD_LENGTH ) - 1, 0 );
+	const int side = std::max( 1, std::min( requestedTileSize, MAX_TILE_SIDE - 2*halo ) ) + 2*halo;
+	if ( !solvers.empty() && solvers[0]->rows() != side )
+	{
+		for ( size_t i = 0; i < solvers.size(); ++i )
+		{
+			delete solvers[i];
+		}
+		solvers.clear();
+	}
+	tileSize = side - 2*halo;
+	while ( int(solvers.size()) < numberOfThreads )
+	{
+		solvers.push_back( new WordHeroSolver( dictionary, side, side ) );
+	}
+	for ( size_t i = 0; i < solvers.size(); ++i )
+	{
+		solvers[i]->setOverlay( addedWords, bannedWords );
+	}
+}
+
+bool TiledSolver::solve( std::istream& in )
+{
+	wordsFound.clear();
+	band.clear();
+	bandTop = 0;
+	nRows = nCols = 0;
+	prepareSolvers();
+
+	bool atEnd = false;
+	for ( int coreTop = 0; ; coreTop += tileSize )
+	{
+		// The band is rows [coreTop - halo, coreTop + tileSize + halo).
+		while ( !band.empty() && bandTop < coreTop - halo )
+		{
+			band.pop_front();
+			bandTop += 1;
+		}
+		std::string row;
+		while ( !atEnd && nRows < coreTop + tileSize + halo )
+		{
+			if ( !std::getline( in, row ) )
+			{
+				atEnd = true;
+				break;
+			}
+			if ( !row.empty() && row[row.size()-1] == '\r' )
+			{
+				row.erase( row.size()-1 );
+			}
+			if ( row.empty() )
+			{
+				atEnd = true;
+				break;
+			}
+			if ( nRows == 0 )
+			{
+				nCols = row.size();
+			}
+			else if ( int(row.size()) != nCols )
+			{
+				return false;
+			}
+			for ( size_t i = 0; i < row.size(); ++i )
+			{
+				row[i] = toupper( row[i] );
+			}
+			if ( band.empty() )
+			{
+				bandTop = nRows;
+			}
+			band.push_back( row );
+			nRows += 1;
+		}
+		if ( coreTop >= nRows )
+		{
+			break;
+		}
+		solveBand( coreTop );
+	}
+	band.clear();
+	return true;
+}
+
+void TiledSolver::solveBand( int coreTop )
+{
+	const int numberOfTiles = (nCols + tileSize - 1) / tileSize;
+	const int workers = std::min( numberOfThreads, numberOfTiles );
+	nextTile = 0;
+	if ( workers == 1 )
+	{
+		solveTiles( solvers[0], coreTop, numberOfTiles );
+		return;
+	}
+	std::vector<std::thread> threads;
+	for ( int i = 0; i < workers; ++i )
+	{
+		threads.push_back( std::thread( &TiledSolver::solveTiles, this, solvers[i], coreTop, numberOfTiles ) );
+	}
+	for ( int i = 0; i < workers; ++i )
+	{
+		threads[i].join();
+	}
+}
+
+// Takes tiles of the band until none are left.
+void TiledSolver::solveTiles( WordHeroSolver* solver, int coreTop, int numberOfTiles )
+{
+	const int side = solver->rows();
+	std::string input( side*side, OUTSIDE );
+	for ( int tile = nextTile++; tile < numberOfTiles; tile = nextTile++ )
+	{
+		const int coreLeft = tile * tileSize;
+		for ( int i = 0; i < side; ++i )
+		{
+			const int row = coreTop - halo + i;
+			const bool rowInGrid = row >= 0 && row < nRows;
+			for ( int j = 0; j < side; ++j )
+			{
+				const int col = coreLeft - halo + j;
+				input[i*side + j] = rowInGrid && col >= 0 && col < nCols
+						? band[row - bandTop][col] : OUTSIDE;
+			}
+		}
+		solver->solveRegion( input, halo, halo, halo + std::min( tileSize, nRows - coreTop ),
+					halo + std::min( tileSize, nCols - coreLeft ) );
+
+		std::lock_guard<std::mutex> lock( resultMutex );
+		wordsFound.insert( solver->begin(), solver->end() );
+	}
+}
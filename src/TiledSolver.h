@@ -0,0 +1,75 @@
+#ifndef _TILEDSOLVER_H
+#define _TILEDSOLVER_H
+
+#include "WordHeroSolver.h"
+#include "Dictionary.h"
+#include "Trie.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+#include <istream>
+#include <mutex>
+#include <atomic>
+
+// Solves grids far larger than one solver board, such as 1000x1000 and
+//   bigger word-search posters. The grid is cut into square tiles, and each
+//   tile is solved with a border of halo cells on every side, where halo is
+//   one less than the longest word. A path that starts in a tile's core never
+//   leaves the core plus its border, so solving every tile with
+//   WordHeroSolver::solveRegion over its core finds exactly the words of the
+//   whole grid. Outside the grid, the border is padded with cells that match
+//   no letter.
+//
+// The grid is read one row per line, one band of tiles at a time: a tile row
+//   plus the halo rows above and below it. Only that band is held, so memory
+//   grows with the grid's width but not its height. The tiles of a band are
+//   solved in parallel, and each worker's solver covers one bordered tile.
+//   The merged result grows only with the number of distinct words.
+class TiledSolver
+{
+public:
+	// tileSize is the side of a tile's core. It is reduced if needed so a
+	//   bordered tile has at most 256 cells on a side.
+	TiledSolver( const Dictionary& dictionary, int tileSize = 192, int numberOfThreads = 1 );
+	~TiledSolver();
+
+	// See WordHeroSolver::setOverlay. Added words widen the halo if they are
+	//   longer than any dictionary word.
+	void setOverlay( const Trie* added, const Trie* banned );
+
+	// Reads the grid, one row per line, until the end of the input or a blank
+	//   line, and solves it. Returns false if the rows are not all the same width.
+	bool solve( std::istream& in );
+
+	typedef std::set<std::string, sortByStringLength> WordSet;
+	const WordSet& words() const { return wordsFound; }
+	int rows() const { return nRows; }
+	int cols() const { return nCols; }
+private:
+	const Dictionary& dictionary;
+	const Trie* addedWords;
+	const Trie* bannedWords;
+	int requestedTileSize;
+	int numberOfThreads;
+	int tileSize;
+	int halo;
+	int nRows;
+	int nCols;
+	// The rows of the current band; band[0] is grid row bandTop.
+	std::deque<std::string> band;
+	int bandTop;
+	std::vector<WordHeroSolver*> solvers;
+	std::atomic<int> nextTile;
+	std::mutex resultMutex;
+	WordSet wordsFound;
+
+	TiledSolver( const TiledSolver& ) = delete;
+	TiledSolver& operator=( const TiledSolver& ) = delete;
+
+	void prepareSolvers();
+	void solveBand( int coreTop );
+	void solveTiles( WordHeroSolver* solver, int coreTop, int numberOfTiles );
+};
+
+#endif
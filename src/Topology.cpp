@@ -0,0 +1,170 @@
+
+#include "Topology.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
+
+// Adds the next cell, adjacent to the cells in around (in any order, with
+//   repeats). Its own number is the cell count before the call.
+void Topology::appendCell( std::vector<int>& around )
+{
+	const int cell = cells();
+	std::sort( around.begin(), around.end() );
+	around.erase( std::unique( around.begin(), around.end() ), around.end() );
+	around.erase( std::remove( around.begin(), around.end(), cell ), around.end() );
+	adjacency.insert( adjacency.end(), around.begin(), around.end() );
+	offsets.push_back( adjacency.size() );
+	longest = std::max( longest, int(around.size()) );
+}
+
+Topology Topology::grid( int rows, int cols )
+{
+	Topology topology;
+	std::vector<int> around;
+	for ( int x = 0; x < rows; ++x )
+	{
+		for ( int y = 0; y < cols; ++y )
+		{
+			around.clear();
+			for ( int dx = -1; dx <= 1; ++dx )
+			{
+				for ( int dy = -1; dy <= 1; ++dy )
+				{
+					if ( x + dx >= 0 && x + dx < rows && y + dy >= 0 && y + dy < cols )
+					{
+						around.push_back( (x + dx)*cols + y + dy );
+					}
+				}
+			}
+			topology.appendCell( around );
+		}
+	}
+	return topology;
+}
+
+Topology Topology::torus( int rows, int cols )
+{
+	Topology topology;
+	std::vector<int> around;
+	for ( int x = 0; x < rows; ++x )
+	{
+		for ( int y = 0; y < cols; ++y )
+		{
+			// On boards under three cells across, both ways round reach the same
+			//   cell; appendCell drops the repeat.
+			around.clear();
+			for ( int dx = -1; dx <= 1; ++dx )
+			{
+				for ( int dy = -1; dy <= 1; ++dy )
+				{
+					around.push_back( (x + dx + rows) % rows * cols + (y + dy + cols) % cols );
+				}
+			}
+			topology.appendCell( around );
+		}
+	}
+	return topology;
+}
+
+Topology Topology::hex( int rows, int cols )
+{
+	Topology topology;
+	std::vector<int> around;
+	for ( int x = 0; x < rows; ++x )
+	{
+		// The cells above and below are this column and the one toward the
+		//   shift: left of an even row, right of an odd one.
+		const int shift = x % 2 ? 1 : -1;
+		for ( int y = 0; y < cols; ++y )
+		{
+			around.clear();
+			for ( int dx = -1; dx <= 1; ++dx )
+			{
+				const int first = dx ? std::min( y, y + shift ) : y - 1;
+				const int last = dx ? std::max( y, y + shift ) : y + 1;
+				for ( int ny = first; ny <= last; ++ny )
+				{
+					if ( x + dx >= 0 && x + dx < rows && ny >= 0 && ny < cols )
+					{
+						around.push_back( (x + dx)*cols + ny );
+					}
+				}
+			}
+			topology.appendCell( around );
+		}
+	}
+	return topology;
+}
+
+Topology Topology::cube( int side )
+{
+	Topology topology;
+	std::vector<int> around;
+	for ( int z = 0; z < side; ++z )
+	{
+		for ( int x = 0; x < side; ++x )
+		{
+			for ( int y = 0; y < side; ++y )
+			{
+				around.clear();
+				for ( int dz = -1; dz <= 1; ++dz )
+				{
+					for ( int dx = -1; dx <= 1; ++dx )
+					{
+						for ( int dy = -1; dy <= 1; ++dy )
+						{
+							if ( z + dz >= 0 && z + dz < side && x + dx >= 0 && x + dx < side
+								&& y + dy >= 0 && y + dy < side )
+							{
+								around.push_back( ((z + dz)*side + x + dx)*side + y + dy );
+							}
+						}
+					}
+				}
+				topology.appendCell( around );
+			}
+		}
+	}
+	return topology;
+}
+
+Topology Topology::masked( const Topology& base, const std::string& shape )
+{
+	Topology topology;
+	std::vector<int> around;
+	for ( int cell = 0; cell < base.cells(); ++cell )
+	{
+		around.clear();
+		const bool isHole = cell < int(shape.size()) && (shape[cell] == '.' || shape[cell] == ' ');
+		for ( const int* next = base.neighbors( cell ); next != base.neighborsEnd( cell ) && !isHole; ++next )
+		{
+			if ( !(*next < int(shape.size()) && (shape[*next] == '.' || shape[*next] == ' ')) )
+			{
+				around.push_back( *next );
+			}
+		}
+		topology.appendCell( around );
+	}
+	return topology;
+}
+
+Topology Topology::fromEdges( int cells, const std::vector<std::pair<int, int> >& edges )
+{
+	std::vector<std::vector<int> > lists( std::max( cells, 0 ) );
+	for ( size_t i = 0; i < edges.size(); ++i )
+	{
+		const int a = edges[i].first, b = edges[i].second;
+		if ( a >= 0 && a < cells && b >= 0 && b < cells )
+		{
+			lists[a].push_back( b );
+			lists[b].push_back( a );
+		}
+	}
+	Topology topology;
+	for ( size_t cell = 0; cell < lists.size(); ++cell )
+	{
+		topology.appendCell( lists[cell] );
+	}
+	return topology;
+}
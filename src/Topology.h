@@ -0,0 +1,58 @@
+#ifndef _TOPOLOGY_H
+#define _TOPOLOGY_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// Which cells of a board are adjacent, as a compressed sparse row graph:
+//   the neighbors of every cell are stored one cell after another in a
+//   single array. Cells are numbered in board input order, one per
+//   character. Each cell's neighbors are sorted, so a search reads them in
+//   one forward sweep and, on a grid, visits them in the order the original
+//   eight-way search did.
+//
+// The factories build the layouts game modes use; fromEdges takes any
+//   other graph. A Topology is read-only once built, so solvers can share
+//   one (see WordHeroSolver::setTopology).
+class Topology
+{
+public:
+	Topology() : offsets(1, 0), longest(0) {}
+
+	// rows x cols, each cell adjacent to the up to eight around it.
+	static Topology grid( int rows, int cols );
+	// grid whose edges wrap around, so every cell has eight neighbors.
+	static Topology torus( int rows, int cols );
+	// Hexagonal cells in rows, odd rows shifted half a cell right, so each
+	//   touches the two beside it and two above and below.
+	static Topology hex( int rows, int cols );
+	// A cube of side^3 cells, one side x side layer after another; each
+	//   cell touches the up to 26 around it. The cells are numbered like a
+	//   (side*side) x side grid of the layers stacked top to bottom.
+	static Topology cube( int side );
+	// base without the cells whose shape character is '.' or ' ', for
+	//   irregular boards: those cells keep their place in the numbering but
+	//   no cell is adjacent to them.
+	static Topology masked( const Topology& base, const std::string& shape );
+	// Cells [0, cells) joined by undirected edges. Self loops, repeated
+	//   edges and edges to cells out of range are dropped.
+	static Topology fromEdges( int cells, const std::vector<std::pair<int, int> >& edges );
+
+	int cells() const { return offsets.size() - 1; }
+	// The neighbors of a cell are [neighbors(cell), neighborsEnd(cell)).
+	const int* neighbors( int cell ) const { return adjacency.data() + offsets[cell]; }
+	const int* neighborsEnd( int cell ) const { return adjacency.data() + offsets[cell+1]; }
+	int degree( int cell ) const { return offsets[cell+1] - offsets[cell]; }
+	// The most neighbors of any cell.
+	int maxDegree() const { return longest; }
+private:
+	// Cell i's neighbors are adjacency[offsets[i], offsets[i+1]).
+	std::vector<int> offsets;
+	std::vector<int> adjacency;
+	int longest;
+
+	void appendCell( std::vector<int>& around );
+};
+
+#endif
@@ -0,0 +1,99 @@
+
+#include "Trie.h"
+#include <string>
+#include <fstream>
+#include <cctype>
+#include <algorithm>
+
+
+Trie::Trie()
+	: nodes(2), numberOfWords(0), longestWord(0)
+{
+	// nodes[0] is the NULL node and nodes[1] is the root.
+}
+
+void Trie::insert( const std::string& word )
+{
+	int trieIdx = ROOT;
+	for ( size_t i = 0; i < word.size(); ++i )
+	{
+		char theChar = toupper( word[i] );
+		if ( theChar < 'A' || theChar > 'Z' )
+		{
+			// The board only holds 'A'-'Z' so a word with any other char can never be found.
+			return;
+		}
+	}
+	for ( size_t i = 0; i < word.size(); ++i )
+	{
+		int letter = toupper( word[i] ) - 'A';
+		if ( !nodes[trieIdx].child[letter] )
+		{
+			nodes[trieIdx].child[letter] = nodes.size();
+			nodes.push_back( Node() );
+		}
+		trieIdx = nodes[trieIdx].child[letter];
+	}
+	if ( trieIdx != ROOT && !nodes[trieIdx].endOfWord )
+	{
+		nodes[trieIdx].endOfWord = true;
+		numberOfWords += 1;
+		longestWord = std::max( longestWord, int(word.size()) );
+	}
+}
+
+// Reads one word per line; blank lines and trailing '\r' are ignored.
+bool Trie::load( const char* file )
+{
+	std::ifstream input( file );
+	if ( !input )
+	{
+		return false;
+	}
+	std::string word;
+	while ( std::getline( input, word ) )
+	{
+		if ( !word.empty() && word[word.size()-1] == '\r' )
+		{
+			word.erase( word.size()-1 );
+		}
+		if ( !word.empty() )
+		{
+			insert( word );
+		}
+	}
+	return true;
+}
+
+bool Trie::contains( const std::string& word ) const
+{
+	return contains( word.data(), word.size() );
+}
+
+bool Trie::contains( const char* word, size_t length ) const
+{
+	int trieIdx = ROOT;
+	for ( size_t i = 0; i < length && trieIdx; ++i )
+	{
+		trieIdx = child( trieIdx, toupper( word[i] ) );
+	}
+	return trieIdx && trieIdx != ROOT && isEndOfWord( trieIdx );
+}
+
+int Trie::find( const std::string& word ) const
+{
+	int trieIdx = ROOT;
+	for ( size_t i = 0; i < word.size() && trieIdx; ++i )
+	{
+		trieIdx = child( trieIdx, toupper( word[i] ) );
+	}
+	return trieIdx;
+}
+
+void Trie::clear()
+{
+	nodes.resize( 2 );
+	nodes[ROOT] = Node();
+	numberOfWords = 0;
+	longestWord = 0;
+}
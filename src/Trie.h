@@ -0,0 +1,56 @@
+
+#ifndef _TRIE_H
+#define _TRIE_H
+
+#include <string>
+#include <vector>
+
+// A small, mutable trie used to overlay runtime word lists on top of the
+//   shipped DAWG (e.g. per-tenant added words or a banned-words filter).
+//   Node indices follow the DAWG convention: index 0 is the NULL node, so a
+//   child lookup that fails returns 0 and can be tested like DAWG_CHILD.
+class Trie
+{
+public:
+	static const int ROOT = 1;
+
+	Trie();
+
+	void insert( const std::string& word );
+	bool load( const char* file );
+	bool contains( const std::string& word ) const;
+	bool contains( const char* word, size_t length ) const;
+	// The node a word ends on (whether or not it is a word), or 0 if no path.
+	int find( const std::string& word ) const;
+	// Empties the trie but keeps its memory for reuse.
+	void clear();
+	int size() const { return numberOfWords; }
+	// Length of the longest word (0 when empty).
+	int maxLength() const { return longestWord; }
+	// Every word ends on its own node, so a node index also identifies a word.
+	int nodeCount() const { return nodes.size(); }
+
+	int child( int trieIdx, char theChar ) const
+	{
+		if ( theChar < 'A' || theChar > 'Z' )
+		{
+			return 0;
+		}
+		return nodes[trieIdx].child[theChar - 'A'];
+	}
+	bool isEndOfWord( int trieIdx ) const { return nodes[trieIdx].endOfWord; }
+
+private:
+	struct Node
+	{
+		int child[26];
+		bool endOfWord;
+		Node() : endOfWord(false) { for ( int i = 0; i < 26; ++i ) child[i] = 0; }
+	};
+
+	std::vector<Node> nodes;
+	int numberOfWords;
+	int longestWord;
+};
+
+#endif
@@ -5,120 +5,1855 @@
 #include <set>
 #include <iostream>
 #include <cassert>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <chrono>
 
 
 WordHeroSolver::WordHeroSolver( int NRows, int NCols )
-	: nRows(NRows), nCols(NCols) 
+	: nRows(NRows), nCols(NCols), ownedDictionary(new Dictionary),
+	  addedWords(NULL), bannedWords(NULL)
 {
 	// TODO(ljdelight): verify nrows/ncols are positive. Else, throw exception
-	board = new Char[nRows*nCols];
-	dawg = initDawg( "dictionary.dat" );
-	if ( !dawg )
+	if ( !ownedDictionary->load( "dictionary.dat" ) )
 	{
 		std::cerr << "could not initialize the DAWG (bad file?)" << std::endl;
 		exit(1);
 	}
+	dictionary = ownedDictionary;
+	dawg = ownedDictionary->nodes();
+	init();
+}
+WordHeroSolver::WordHeroSolver( const Dictionary& dictionary, int NRows, int NCols )
+	: nRows(NRows), nCols(NCols), ownedDictionary(NULL), dictionary(&dictionary),
+	  dawg(dictionary.nodes()), addedWords(NULL), bannedWords(NULL)
+{
+	assert( dawg );
+	init();
+}
+void WordHeroSolver::init()
+{
+	// Classic Boggle points: 3-4 letters 1, 5 letters 2, 6 letters 3, 7 letters 5, 8+ letters 11.
+	static const int BOGGLE_POINTS[] = { 0, 0, 0, 1, 1, 2, 3, 5, 11 };
+	board = new Char[nRows*nCols];
+	gridTopology = Topology::grid( nRows, nCols );
+	topology = &gridTopology;
+	summary = NULL;
+	recordPaths = false;
+	cache = NULL;
+	diskCache = NULL;
+	gaddag = NULL;
+	searchDawg = true;
+	viewMode = false;
+	hasWildcards = false;
+	engine = ENGINE_AUTO;
+	usedEngine = ENGINE_AUTO;
+	regionTop = regionLeft = 0;
+	regionBottom = nRows;
+	regionRight = nCols;
+	setConstraints( NULL );
+	currentPath.resize( MAX_STRING_LENGTH );
+	setScoreTable( BOGGLE_POINTS, sizeof(BOGGLE_POINTS)/sizeof(BOGGLE_POINTS[0]) );
+	seenWords.resize( (dictionary->numberOfWords() + 63) / 64 );
+}
+WordHeroSolver::~WordHeroSolver()
+{
+	delete[] board;
+	delete ownedDictionary;
+}
+
+void WordHeroSolver::setOverlay( const Trie* added, const Trie* banned )
+{
+	addedWords = added;
+	bannedWords = banned;
+}
+
+bool WordHeroSolver::setTopology( const Topology* topology )
+{
+	if ( topology && topology->cells() != nRows*nCols )
+	{
+		return false;
+	}
+	this->topology = topology ? topology : &gridTopology;
+	// The frontier engine rebuilds its masks from the new neighbor lists.
+	neighborMasks.clear();
+	return true;
+}
+
+void WordHeroSolver::setConstraints( const SolveConstraints* constraints )
+{
+	isConstrained = constraints != NULL;
+	this->constraints = constraints ? *constraints : SolveConstraints();
+	SolveConstraints& c = this->constraints;
+	for ( size_t i = 0; i < c.prefix.size(); ++i )
+	{
+		c.prefix[i] = toupper( c.prefix[i] );
+	}
+	for ( size_t i = 0; i < c.suffix.size(); ++i )
+	{
+		c.suffix[i] = toupper( c.suffix[i] );
+	}
+	c.letter = toupper( c.letter );
+	requiredLetterBit = c.letter >= 'A' && c.letter <= 'Z' ? uint32_t(1) << (c.letter - 'A') : 0;
+	// Nothing shorter than the suffix can end with it.
+	minWordLength = std::max( c.minLength, int(c.suffix.size()) );
+	minWordLength = std::max( minWordLength, 1 );
+}
+
+void WordHeroSolver::setScoreTable( const int* pointsByLength, int n )
+{
+	for ( int i = 0; i < SolveSummary::MAX_LENGTH; ++i )
+	{
+		scoreTable[i] = n > 0 ? pointsByLength[i < n ? i : n-1] : 0;
+	}
+}
+
+// Fills the board from input, one cell per character, except that '?' is a
+//   wildcard for any letter and [AEIOU] one for the letters listed. Returns
+//   false unless input holds exactly rows*cols cells; the board must not be
+//   searched then, since the cells past the end of input are left over from
+//   the last board.
+bool WordHeroSolver::loadBoard( const char* input, size_t length )
+{
+	const uint32_t ALL_LETTERS = (uint32_t(1) << 26) - 1;
+	const size_t boardSize = nRows*nCols;
+	hasWildcards = false;
+	size_t i = 0, cell = 0;
+	for ( ; i < length && cell < boardSize; ++i, ++cell )
+	{
+		if ( input[i] == Char::WILDCARD )
+		{
+			board[cell] = Char( Char::WILDCARD, ALL_LETTERS );
+			hasWildcards = true;
+		}
+		else if ( input[i] == '[' )
+		{
+			uint32_t letters = 0;
+			for ( i += 1; i < length && input[i] != ']'; ++i )
+			{
+				const int c = toupper( input[i] ) - 'A';
+				letters |= c >= 0 && c < 26 ? uint32_t(1) << c : 0;
+			}
+			board[cell] = Char( Char::WILDCARD, letters );
+			hasWildcards = true;
+		}
+		else
+		{
+			board[cell] = Char( input[i] );
+		}
+	}
+	return i == length && cell == boardSize;
+}
+
+int WordHeroSolver::countCells( std::string& input )
+{
+	int cells = 0;
+	for ( size_t i = 0; i < input.size(); ++i, ++cells )
+	{
+		input[i] = toupper( input[i] );
+		if ( input[i] == '[' )
+		{
+			for ( i += 1; i < input.size() && input[i] != ']'; ++i )
+			{
+				input[i] = toupper( input[i] );
+				if ( input[i] < 'A' || input[i] > 'Z' )
+				{
+					return -1;
+				}
+			}
+			if ( i == input.size() )
+			{
+				return -1;
+			}
+		}
+		else if ( input[i] != Char::WILDCARD && (input[i] < 'A' || input[i] > 'Z') )
+		{
+			return -1;
+		}
+	}
+	return cells;
+}
+
+void WordHeroSolver::solve( const std::string& input )
+{
+	wordsFound.clear();
+	paths.clear();
+	pathBoard.clear();
+	usedEngine = ENGINE_AUTO;
+	if ( !loadBoard( input ) )
+	{
+		return;
+	}
+
+	SOLVER_COUNT( counterValues.reset( nRows*nCols ) );
+
+	// Paths depend on the board's orientation, constraints and overlays are
+	//   not part of the key and the key's rotations assume a grid, so only
+	//   plain solves go through the caches.
+	const bool isRegion = regionTop > 0 || regionLeft > 0 || regionBottom < nRows || regionRight < nCols;
+	const bool useCache = (cache || diskCache) && !recordPaths && !isConstrained && !isRegion
+			&& !hasWildcards && !addedWords && !bannedWords
+			&& topology == &gridTopology && input.size() == size_t(nRows*nCols);
+	const bool useDiskCache = useCache && diskCache;
+	if ( useCache )
+	{
+		ResultCache::canonicalKey( input, nRows, nCols, cacheKey );
+		if ( cache && cache->lookup( cacheKey, cacheValue ) )
+		{
+			// [length][letters] per word, already in result order.
+			for ( size_t at = 0; at < cacheValue.size(); at += 1 + (unsigned char)cacheValue[at] )
+			{
+				wordsFound.insert( wordsFound.end(), std::make_pair(
+						cacheValue.substr( at + 1, (unsigned char)cacheValue[at] ), WordIterator::NO_PATH ) );
+			}
+			return;
+		}
+		if ( useDiskCache && diskCache->lookup( cacheKey, cacheIds ) )
+		{
+			for ( size_t i = 0; i < cacheIds.size(); ++i )
+			{
+				wordsFound.insert( std::make_pair( dictionary->word( cacheIds[i] ), WordIterator::NO_PATH ) );
+			}
+			storeInCache();
+			return;
+		}
+	}
+
+	searchBoard();
+
+	if ( recordPaths && !isConstrained && !isRegion && !hasWildcards && input.size() == size_t(nRows*nCols) )
+	{
+		pathBoard = input;
+	}
+	if ( useCache )
+	{
+		storeInCache();
+	}
+	if ( useDiskCache )
+	{
+		cacheIds.clear();
+		for ( WordIterator::WordMap::const_iterator itr = wordsFound.begin(); itr != wordsFound.end(); ++itr )
+		{
+			cacheIds.push_back( dictionary->wordId( itr->first.data(), itr->first.size() ) );
+		}
+		std::sort( cacheIds.begin(), cacheIds.end() );
+		diskCache->insert( cacheKey, cacheIds );
+	}
+}
+
+// Orders arena words like sortByStringLength.
+struct ArenaOrder
+{
+	const char* arena;
+
+	template <typename Word>
+	bool operator()( const Word& lhs, const Word& rhs ) const
+	{
+		if ( lhs.size != rhs.size )
+		{
+			return lhs.size < rhs.size;
+		}
+		return memcmp( arena + lhs.offset, arena + rhs.offset, lhs.size ) < 0;
+	}
+};
+
+WordSpan WordHeroSolver::solveView( const char* input, size_t length )
+{
+	// Room for 128 words before the first growth.
+	static const size_t FIRST_TABLE_SIZE = 256;
+	wordsFound.clear();
+	paths.clear();
+	pathBoard.clear();
+	wordArena.clear();
+	arenaWords.clear();
+	if ( viewTable.empty() )
+	{
+		viewTable.resize( FIRST_TABLE_SIZE );
+	}
+	std::fill( viewTable.begin(), viewTable.end(), 0 );
+	usedEngine = ENGINE_AUTO;
+	if ( !loadBoard( input, length ) )
+	{
+		return WordSpan();
+	}
+
+	SOLVER_COUNT( counterValues.reset( nRows*nCols ) );
+
+	viewMode = true;
+	searchBoard();
+	viewMode = false;
+
+	ArenaOrder order = { wordArena.empty() ? NULL : &wordArena[0] };
+	std::sort( arenaWords.begin(), arenaWords.end(), order );
+	wordViews.resize( arenaWords.size() );
+	for ( size_t i = 0; i < arenaWords.size(); ++i )
+	{
+		wordViews[i] = WordView( order.arena + arenaWords[i].offset, arenaWords[i].size );
+	}
+	return wordViews.empty() ? WordSpan() : WordSpan( &wordViews[0], &wordViews[0] + wordViews.size() );
+}
+
+static uint32_t hashWord( const char* str, size_t length )
+{
+	uint32_t hash = 2166136261u;
+	for ( size_t i = 0; i < length; ++i )
+	{
+		hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+	}
+	return hash;
+}
+
+// Adds a word to the arena unless it is already there. The table is kept
+//   at most half full, doubling when needed.
+void WordHeroSolver::storeView( const char* str, int strLen )
+{
+	size_t mask = viewTable.size() - 1;
+	size_t slot = hashWord( str, strLen ) & mask;
+	for ( ; viewTable[slot]; slot = (slot + 1) & mask )
+	{
+		const ArenaWord& word = arenaWords[viewTable[slot] - 1];
+		if ( word.size == uint32_t(strLen) && !memcmp( &wordArena[word.offset], str, strLen ) )
+		{
+			return;
+		}
+	}
+	ArenaWord word = { uint32_t(wordArena.size()), uint32_t(strLen) };
+	wordArena.insert( wordArena.end(), str, str + strLen );
+	arenaWords.push_back( word );
+	viewTable[slot] = arenaWords.size();
+	if ( arenaWords.size()*2 <= viewTable.size() )
+	{
+		return;
+	}
+	viewTable.assign( viewTable.size()*2, 0 );
+	mask = viewTable.size() - 1;
+	for ( size_t i = 0; i < arenaWords.size(); ++i )
+	{
+		slot = hashWord( &wordArena[arenaWords[i].offset], arenaWords[i].size ) & mask;
+		while ( viewTable[slot] )
+		{
+			slot = (slot + 1) & mask;
+		}
+		viewTable[slot] = i + 1;
+	}
+}
+
+// Runs the chosen engine over the loaded board and region.
+void WordHeroSolver::searchBoard()
+{
+	char str[MAX_STRING_LENGTH];
+	usedEngine = chooseEngine();
+	if ( usedEngine == ENGINE_DICTIONARY )
+	{
+		indexLetters();
+		dictionaryhelper( str, 0, 1, 0, 0 );
+	}
+	else if ( usedEngine == ENGINE_FRONTIER )
+	{
+		frontierhelper();
+	}
+	else if ( usedEngine == ENGINE_INTERLEAVED )
+	{
+		interleavedhelper();
+	}
+	for ( int i = regionTop; i < regionBottom && usedEngine == ENGINE_BOARD; ++i )
+	{
+		for ( int j = regionLeft; j < regionRight; ++j )
+		{
+#ifdef WORDHERO_COUNTERS
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			solvehelper( str, 0, MAX_STRING_LENGTH, i*nCols + j );
+			counterValues.startCellNs[i*nCols + j] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now() - start ).count();
+#else
+			solvehelper( str, 0, MAX_STRING_LENGTH, i*nCols + j );
+#endif
+		}
+	}
+}
+
+void WordHeroSolver::solveRegion( const std::string& input, int top, int left, int bottom, int right )
+{
+	regionTop = std::max( top, 0 );
+	regionLeft = std::max( left, 0 );
+	regionBottom = std::min( bottom, nRows );
+	regionRight = std::min( right, nCols );
+	solve( input );
+	regionTop = regionLeft = 0;
+	regionBottom = nRows;
+	regionRight = nCols;
+}
+// Below this many expected board paths, a prefix adds too little to either
+//   engine's cost to be worth estimating.
+static const double ESTIMATE_CUTOFF = 1.0;
+// Fixed work the dictionary engine spends on each prefix it extends.
+static const double PREFIX_OVERHEAD = 40.0;
+
+// Estimates the work of each engine, assuming the board's letters are
+//   placed at random: a prefix then has cellsWith(first letter) paths times,
+//   for each later letter, degree*cellsWith(letter)/cells, where degree is
+//   the most neighbors of any cell (8 on a grid). The board engine tests
+//   every neighbor on every path of every prefix, scanning the DAWG list of
+//   next letters for each. The dictionary engine makes one pass over the
+//   paths of each prefix with two or more words below it; from there it
+//   tries the remaining word until its first path.
+WordHeroSolver::Engine WordHeroSolver::chooseEngine()
+{
+	// The dictionary and interleaved engines keep 16-bit paths, and the
+	//   frontier engine keeps a 64-bit mask of visited cells. Only
+	//   solvehelper tries the letters of wildcard cells.
+	if ( addedWords || isConstrained || hasWildcards || nRows*nCols > 65536
+		|| (engine == ENGINE_FRONTIER && nRows*nCols > 64) )
+	{
+		return ENGINE_BOARD;
+	}
+	if ( engine != ENGINE_AUTO )
+	{
+		return engine;
+	}
+	// Merging paths over the same cells beats both on boards that fit the
+	//   frontier engine's mask, with or without repeated letters.
+	if ( nRows*nCols <= 64 )
+	{
+		return ENGINE_FRONTIER;
+	}
+	indexLetters();
+	double boardEstimate = nRows*nCols, dictionaryEstimate = 0;
+	estimatehelper( 1, 0, 0, boardEstimate, dictionaryEstimate );
+	return dictionaryEstimate < boardEstimate ? ENGINE_DICTIONARY : ENGINE_BOARD;
+}
+
+void WordHeroSolver::estimatehelper( int listIdx, int depth, double parentPaths,
+				double& boardCost, double& dictionaryCost )
+{
+	const double cells = nRows*nCols;
+	const double degree = topology->maxDegree();
+	// Only the region's cells start words.
+	const double regionShare = (regionBottom - regionTop) * (regionRight - regionLeft) / cells;
+	for ( int dawgIdx = listIdx; dawgIdx; dawgIdx = DAWG_NEXT(dawg, dawgIdx) )
+	{
+		const int c = DAWG_LETTER(dawg, dawgIdx) - 'A';
+		if ( c < 0 || c >= 26 )
+		{
+			continue;
+		}
+		const double count = letterStart[c+1] - letterStart[c];
+		const double paths = depth ? parentPaths * degree * count / cells : count * regionShare;
+		if ( paths < ESTIMATE_CUTOFF )
+		{
+			continue;
+		}
+		if ( dictionary->wordsBelow( dawgIdx ) > 1 )
+		{
+			int nextLetters = 0;
+			for ( int childIdx = DAWG_CHILD(dawg, dawgIdx); childIdx; childIdx = DAWG_NEXT(dawg, childIdx) )
+			{
+				nextLetters += 1;
+			}
+			boardCost += degree * paths * (1 + 0.5*nextLetters);
+			dictionaryCost += PREFIX_OVERHEAD + (4 + depth) * paths;
+			estimatehelper( DAWG_CHILD(dawg, dawgIdx), depth + 1, paths, boardCost, dictionaryCost );
+			continue;
+		}
+		// The board engine walks every path of the remaining letters; the
+		//   dictionary engine tries starts until one spells the whole word.
+		double wordPaths = paths, starts = paths;
+		int letters = 1;
+		for ( int chainIdx = dawgIdx; !DAWG_END_OF_WORD(dawg, chainIdx); ++letters )
+		{
+			boardCost += 1.5 * degree * wordPaths;
+			chainIdx = DAWG_CHILD(dawg, chainIdx);
+			const int next = DAWG_LETTER(dawg, chainIdx) - 'A';
+			const double nextCount = next >= 0 && next < 26 ? letterStart[next+1] - letterStart[next] : 0;
+			wordPaths *= degree * nextCount / cells;
+			starts = std::min( starts, nextCount );
+		}
+		dictionaryCost += 4 * letters * std::min( starts, starts / std::max( wordPaths, 1e-9 ) );
+	}
+}
+
+// Fills letterCells and letterStart from the loaded board.
+void WordHeroSolver::indexLetters()
+{
+	const int boardSize = nRows*nCols;
+	std::fill( letterStart, letterStart + 27, 0 );
+	for ( int idx = 0; idx < boardSize; ++idx )
+	{
+		const char c = board[idx].getChar();
+		if ( c >= 'A' && c <= 'Z' )
+		{
+			letterStart[c - 'A' + 1] += 1;
+		}
+	}
+	for ( int c = 0; c < 26; ++c )
+	{
+		letterStart[c+1] += letterStart[c];
+	}
+	letterCells.resize( letterStart[26] );
+	int next[26];
+	std::copy( letterStart, letterStart + 26, next );
+	for ( int idx = 0; idx < boardSize; ++idx )
+	{
+		const char c = board[idx].getChar();
+		if ( c >= 'A' && c <= 'Z' )
+		{
+			letterCells[next[c - 'A']++] = idx;
+		}
+	}
+}
+
+// The dictionary engine. The board paths spelling the prefix str[0,depth)
+//   are pathLevels[depth-1][aboveBegin, aboveEnd). One pass over them finds
+//   the paths for every letter on the DAWG list at listIdx, bucketed by
+//   letter onto pathLevels[depth]. A letter no path reaches ends its whole
+//   branch.
+void WordHeroSolver::dictionaryhelper( char* str, int depth, int listIdx, int aboveBegin, int aboveEnd )
+{
+	if ( int(pathLevels.size()) <= depth )
+	{
+		pathLevels.resize( depth + 1 );
+	}
+	int ranges[27];
+	std::vector<PathStep>& level = pathLevels[depth];
+	level.clear();
+	if ( depth == 0 )
+	{
+		// Every letter cell in the region starts paths.
+		for ( int c = 0; c < 26; ++c )
+		{
+			ranges[c] = level.size();
+			for ( int i = letterStart[c]; i < letterStart[c+1]; ++i )
+			{
+				const int x = letterCells[i] / nCols, y = letterCells[i] % nCols;
+				if ( x >= regionTop && x < regionBottom && y >= regionLeft && y < regionRight )
+				{
+					PathStep step = { letterCells[i], -1 };
+					level.push_back( step );
+				}
+			}
+		}
+		ranges[26] = level.size();
+	}
+	else
+	{
+		uint32_t wanted = 0;
+		for ( int dawgIdx = listIdx; dawgIdx; dawgIdx = DAWG_NEXT(dawg, dawgIdx) )
+		{
+			const int c = DAWG_LETTER(dawg, dawgIdx) - 'A';
+			wanted |= c >= 0 && c < 26 ? uint32_t(1) << c : 0;
+		}
+		for ( int c = 0; c < 26; ++c )
+		{
+			letterBuckets[c].clear();
+		}
+		const std::vector<PathStep>& above = pathLevels[depth-1];
+		for ( int i = aboveBegin; i < aboveEnd; ++i )
+		{
+			// Marking the path makes the visited test one load per neighbor.
+			markPath( depth - 1, i, true );
+			const int cell = above[i].cell;
+			for ( const int* next = topology->neighbors( cell ); next != topology->neighborsEnd( cell ); ++next )
+			{
+				const int c = board[*next].getChar() - 'A';
+				if ( c >= 0 && c < 26 && (wanted & (uint32_t(1) << c)) && !board[*next].isVisited() )
+				{
+					PathStep step = { *next, i };
+					letterBuckets[c].push_back( step );
+				}
+			}
+			markPath( depth - 1, i, false );
+		}
+		for ( int c = 0; c < 26; ++c )
+		{
+			ranges[c] = level.size();
+			level.insert( level.end(), letterBuckets[c].begin(), letterBuckets[c].end() );
+		}
+		ranges[26] = level.size();
+	}
+
+	for ( int dawgIdx = listIdx; dawgIdx; dawgIdx = DAWG_NEXT(dawg, dawgIdx) )
+	{
+		const int c = DAWG_LETTER(dawg, dawgIdx) - 'A';
+		if ( c < 0 || c >= 26 || ranges[c] == ranges[c+1] )
+		{
+			continue;
+		}
+		str[depth] = c + 'A';
+		if ( dictionary->wordsBelow( dawgIdx ) == 1 )
+		{
+			// Only one word is left, so one path for it is enough.
+			chainWord.assign( str, depth );
+			findChain( depth, dawgIdx, ranges[c], ranges[c+1] );
+			continue;
+		}
+		if ( DAWG_END_OF_WORD(dawg, dawgIdx) )
+		{
+			reportPath( depth, ranges[c] );
+		}
+		dictionaryhelper( str, depth + 1, DAWG_CHILD(dawg, dawgIdx), ranges[c], ranges[c+1] );
+	}
+}
+
+// The frontier engine. Level d holds, for every prefix of d+1 letters on
+//   the board, the states (end cell, visited cells) of its paths. Each state
+//   of a prefix is extended to every unvisited neighbor that holds one of the
+//   next letters, one mask operation per state and letter. Paths that end on
+//   the same cell having visited the same cells have the same future, so
+//   each prefix keeps only one of them. Prefixes are never merged, even when
+//   the DAWG shares their node, because they spell different words.
+void WordHeroSolver::frontierhelper()
+{
+	const int boardSize = nRows*nCols;
+	if ( int(neighborMasks.size()) != boardSize )
+	{
+		neighborMasks.assign( boardSize, 0 );
+		for ( int idx = 0; idx < boardSize; ++idx )
+		{
+			for ( const int* next = topology->neighbors( idx ); next != topology->neighborsEnd( idx ); ++next )
+			{
+				neighborMasks[idx] |= uint64_t(1) << *next;
+			}
+		}
+	}
+	std::fill( letterMasks, letterMasks + 26, 0 );
+	uint32_t boardLetters = 0;
+	for ( int idx = 0; idx < boardSize; ++idx )
+	{
+		const int c = board[idx].getChar() - 'A';
+		if ( c >= 0 && c < 26 && !board[idx].isVisited() )
+		{
+			letterMasks[c] |= uint64_t(1) << idx;
+			boardLetters |= uint32_t(1) << c;
+		}
+	}
+
+	if ( frontierLevels.empty() )
+	{
+		frontierLevels.resize( 1 );
+		frontierGroups.resize( 1 );
+	}
+	frontierLevels[0].clear();
+	frontierGroups[0].clear();
+	for ( int c = 0; c < 26; ++c )
+	{
+		const int dawgIdx = dictionary->entryNode( 'A' + c );
+		if ( !dawgIdx || !(boardLetters & (uint32_t(1) << c)) )
+		{
+			continue;
+		}
+		FrontierGroup group = { dawgIdx, int(frontierLevels[0].size()), 0 };
+		for ( uint64_t cells = letterMasks[c]; cells; cells &= cells - 1 )
+		{
+			const int idx = __builtin_ctzll( cells );
+			if ( idx / nCols >= regionTop && idx / nCols < regionBottom
+				&& idx % nCols >= regionLeft && idx % nCols < regionRight )
+			{
+				FrontierState state = { uint64_t(1) << idx, idx, -1 };
+				frontierLevels[0].push_back( state );
+				SOLVER_COUNT( counterValues.nodesExpanded += 1 );
+			}
+		}
+		group.end = frontierLevels[0].size();
+		if ( group.end > group.begin )
+		{
+			frontierGroups[0].push_back( group );
+			if ( DAWG_END_OF_WORD(dawg, dawgIdx) )
+			{
+				reportState( 0, group.begin );
+			}
+		}
+	}
+
+	for ( int depth = 0; !frontierGroups[depth].empty() && depth + 2 < MAX_STRING_LENGTH; ++depth )
+	{
+		if ( int(frontierLevels.size()) <= depth + 1 )
+		{
+			frontierLevels.resize( depth + 2 );
+			frontierGroups.resize( depth + 2 );
+		}
+		const std::vector<FrontierState>& states = frontierLevels[depth];
+		std::vector<FrontierState>& next = frontierLevels[depth+1];
+		std::vector<FrontierGroup>& nextGroups = frontierGroups[depth+1];
+		next.clear();
+		nextGroups.clear();
+		for ( size_t g = 0; g < frontierGroups[depth].size(); ++g )
+		{
+			const FrontierGroup& group = frontierGroups[depth][g];
+			const uint32_t choices = dictionary->childLetters( group.dawgIdx );
+			const int listIdx = DAWG_CHILD(dawg, group.dawgIdx);
+			for ( uint32_t letters = choices & boardLetters; letters; letters &= letters - 1 )
+			{
+				const int c = __builtin_ctz( letters );
+				const int begin = next.size();
+				for ( int i = group.begin; i < group.end; ++i )
+				{
+					const FrontierState& from = states[i];
+					SOLVER_COUNT( counterValues.visitedRejects
+						+= __builtin_popcountll( neighborMasks[from.cell] & from.visited & letterMasks[c] ) );
+					for ( uint64_t cells = neighborMasks[from.cell] & ~from.visited & letterMasks[c];
+						cells; cells &= cells - 1 )
+					{
+						const int idx = __builtin_ctzll( cells );
+						FrontierState state = { from.visited | (uint64_t(1) << idx), idx, i };
+						next.push_back( state );
+					}
+				}
+				if ( int(next.size()) == begin )
+				{
+					SOLVER_COUNT( counterValues.pruneDepths[std::min( depth + 1, SolverCounters::MAX_DEPTH - 1 )] += 1 );
+					continue;
+				}
+				std::sort( next.begin() + begin, next.end() );
+				next.erase( std::unique( next.begin() + begin, next.end() ), next.end() );
+				SOLVER_COUNT( counterValues.nodesExpanded += next.size() - begin );
+				const int dawgIdx = listIdx + __builtin_popcount( choices & ((uint32_t(1) << c) - 1) );
+				FrontierGroup child = { dawgIdx, begin, int(next.size()) };
+				nextGroups.push_back( child );
+				if ( DAWG_END_OF_WORD(dawg, dawgIdx) )
+				{
+					reportState( depth + 1, begin );
+				}
+			}
+		}
+	}
+}
+
+// Reports the word spelled by the path of a state on frontierLevels[depth].
+void WordHeroSolver::reportState( int depth, int state )
+{
+	if ( depth + 1 < minWordLength )
+	{
+		return;
+	}
+	chainWord.resize( depth + 1 );
+	for ( int d = depth; d >= 0; state = frontierLevels[d--][state].parent )
+	{
+		currentPath[d] = frontierLevels[d][state].cell;
+		chainWord[d] = board[currentPath[d]].getChar();
+	}
+	if ( !(bannedWords && bannedWords->contains( chainWord )) )
+	{
+		reportWord( chainWord.data(), chainWord.size(), &currentPath[0] );
+	}
+}
+
+// Walks the interleaved engine keeps in flight. Each waits on one DAWG
+//   node, so this many misses can overlap.
+static const int WALK_CONTEXTS = 8;
+
+// The interleaved engine. Each walk is solvehelper's search from one start
+//   cell, kept on an explicit stack so it can stop after any step. The walks
+//   take turns one step at a time; a step ends by prefetching the node the
+//   walk reads next, which then has the other walks' steps to arrive. A walk
+//   that runs out of moves takes the region's next start cell. Words are
+//   deduplicated by Dictionary id in seenWords, as summarize() does.
+void WordHeroSolver::interleavedhelper()
+{
+	const int regionWidth = regionRight - regionLeft;
+	const int regionCells = (regionBottom - regionTop) * regionWidth;
+	memset( &seenWords[0], 0, seenWords.size()*sizeof(uint64_t) );
+	walks.resize( WALK_CONTEXTS );
+	for ( size_t i = 0; i < walks.size(); ++i )
+	{
+		walks[i].depth = 0;
+		walks[i].nextIdx = 0;
+		walks[i].visited.assign( (nRows*nCols + 63) / 64, 0 );
+	}
+	int start = 0;
+	for ( bool running = true; running; )
+	{
+		running = false;
+		for ( size_t i = 0; i < walks.size(); ++i )
+		{
+			Walk& walk = walks[i];
+			while ( !advanceWalk( walk ) && start < regionCells )
+			{
+				const int cell = (regionTop + start / regionWidth)*nCols + regionLeft + start % regionWidth;
+				start += 1;
+				walk.nextCell = cell;
+				walk.nextIdx = dictionary->entryNode( board[cell].getChar() );
+				if ( walk.nextIdx )
+				{
+					dictionary->prefetch( walk.nextIdx );
+					break;
+				}
+			}
+			running = running || walk.depth || walk.nextIdx;
+		}
+	}
+}
+
+// Steps a walk onto its waiting cell, then finds its next move and
+//   prefetches that node. Returns false once the walk has no move left.
+bool WordHeroSolver::advanceWalk( Walk& walk )
+{
+	if ( walk.nextIdx )
+	{
+		const int dawgIdx = walk.nextIdx;
+		const int depth = walk.depth++;
+		walk.nextIdx = 0;
+		SOLVER_COUNT( counterValues.nodesExpanded += 1 );
+		walk.ranks[depth] = depth ? dictionary->rankStep( walk.nodes[depth-1], walk.ranks[depth-1], dawgIdx )
+				: dictionary->rankStep( 0, 0, dawgIdx );
+		walk.nodes[depth] = dawgIdx;
+		walk.nextNeighbor[depth] = 0;
+		walk.str[depth] = board[walk.nextCell].getChar();
+		walk.path[depth] = walk.nextCell;
+		// Most hits repeat a word already found, so they are caught by id
+		//   before any string is built.
+		uint64_t& seen = seenWords[walk.ranks[depth] / 64];
+		const uint64_t mask = uint64_t(1) << (walk.ranks[depth] % 64);
+		if ( DAWG_END_OF_WORD(dawg, dawgIdx) && !(seen & mask) )
+		{
+			seen |= mask;
+			if ( !(bannedWords && bannedWords->contains( walk.str, walk.depth )) )
+			{
+				reportWord( walk.str, walk.depth, walk.path );
+			}
+		}
+		else if ( DAWG_END_OF_WORD(dawg, dawgIdx) && walk.depth >= minWordLength )
+		{
+			SOLVER_COUNT( ++counterValues.duplicateHits );
+		}
+		if ( !dictionary->childLetters( dawgIdx ) || walk.depth + 1 >= Walk::MAX_DEPTH )
+		{
+			walk.depth -= 1;
+		}
+		else
+		{
+			walk.visited[walk.nextCell / 64] |= uint64_t(1) << (walk.nextCell % 64);
+		}
+	}
+	while ( walk.depth )
+	{
+		const int top = walk.depth - 1;
+		const int cell = walk.path[top];
+		const int* neighbors = topology->neighbors( cell );
+		const int degree = topology->degree( cell );
+		const uint32_t choices = dictionary->childLetters( walk.nodes[top] );
+		while ( walk.nextNeighbor[top] < degree )
+		{
+			const int next = neighbors[walk.nextNeighbor[top]++];
+			const int c = board[next].getChar() - 'A';
+			if ( walk.visited[next / 64] & (uint64_t(1) << (next % 64)) )
+			{
+				SOLVER_COUNT( ++counterValues.visitedRejects );
+				continue;
+			}
+			if ( c < 0 || c >= 26 || !(choices & (uint32_t(1) << c)) )
+			{
+				SOLVER_COUNT( counterValues.pruneDepths[std::min( walk.depth, SolverCounters::MAX_DEPTH - 1 )] += 1 );
+				continue;
+			}
+			walk.nextCell = next;
+			walk.nextIdx = DAWG_CHILD(dawg, walk.nodes[top]) + __builtin_popcount( choices & ((uint32_t(1) << c) - 1) );
+			dictionary->prefetch( walk.nextIdx );
+			return true;
+		}
+		walk.visited[cell / 64] &= ~(uint64_t(1) << (cell % 64));
+		walk.depth -= 1;
+	}
+	return false;
+}
+
+// Sets or clears the visited flag on every cell of a path, from the step
+//   on pathLevels[depth] back to its first cell.
+void WordHeroSolver::markPath( int depth, int step, bool visited )
+{
+	for ( ; depth >= 0; step = pathLevels[depth--][step].parent )
+	{
+		Char& cell = board[pathLevels[depth][step].cell];
+		visited ? cell.setVisited() : cell.setNotVisited();
+	}
+}
+
+// Completes chainWord (the prefix) with the only word below DAWG node
+//   dawgIdx, whose letter's paths are pathLevels[depth][begin, end), and
+//   looks for one path that spells it. The search continues those paths or,
+//   when there are fewer of them, starts from the cells of the word's
+//   rarest letter.
+bool WordHeroSolver::findChain( int depth, int dawgIdx, int begin, int end )
+{
+	for ( int chainIdx = dawgIdx; ; chainIdx = DAWG_CHILD(dawg, chainIdx) )
+	{
+		chainWord += char(DAWG_LETTER(dawg, chainIdx));
+		if ( DAWG_END_OF_WORD(dawg, chainIdx) )
+		{
+			break;
+		}
+	}
+	if ( int(chainWord.size()) < minWordLength || (bannedWords && bannedWords->contains( chainWord )) )
+	{
+		return false;
+	}
+	if ( int(chainWord.size()) == depth + 1 )
+	{
+		reportPath( depth, begin );
+		return true;
+	}
+
+	int start = 0, starts = end - begin;
+	for ( int i = depth + 1; i < int(chainWord.size()); ++i )
+	{
+		const int c = chainWord[i] - 'A';
+		if ( c < 0 || c >= 26 )
+		{
+			return false;
+		}
+		if ( letterStart[c+1] - letterStart[c] < starts )
+		{
+			start = i;
+			starts = letterStart[c+1] - letterStart[c];
+		}
+	}
+
+	bool found = false;
+	if ( start )
+	{
+		const int c = chainWord[start] - 'A';
+		for ( int i = letterStart[c]; i < letterStart[c+1] && !found; ++i )
+		{
+			found = tracehelper( chainWord, start, letterCells[i], start );
+		}
+	}
+	for ( int i = begin; i < end && !start && !found; ++i )
+	{
+		markPath( depth, i, true );
+		const int cell = pathLevels[depth][i].cell;
+		for ( const int* next = topology->neighbors( cell ); next != topology->neighborsEnd( cell ) && !found; ++next )
+		{
+			found = tracehelper( chainWord, depth + 1, *next );
+		}
+		markPath( depth, i, false );
+		// tracehelper filled in the rest of currentPath.
+		for ( int d = depth, step = i; found && d >= 0; step = pathLevels[d--][step].parent )
+		{
+			currentPath[d] = pathLevels[d][step].cell;
+		}
+	}
+	if ( found )
+	{
+		reportWord( chainWord.data(), chainWord.size(), &currentPath[0] );
+	}
+	return found;
+}
+
+// Reports the prefix spelled by the step on pathLevels[depth] as a word.
+void WordHeroSolver::reportPath( int depth, int step )
+{
+	chainWord.resize( depth + 1 );
+	for ( int d = depth; d >= 0; step = pathLevels[d--][step].parent )
+	{
+		currentPath[d] = pathLevels[d][step].cell;
+		chainWord[d] = board[currentPath[d]].getChar();
+	}
+	if ( int(chainWord.size()) >= minWordLength && !(bannedWords && bannedWords->contains( chainWord )) )
+	{
+		reportWord( chainWord.data(), chainWord.size(), &currentPath[0] );
+	}
+}
+
+void WordHeroSolver::update( const std::string& input )
+{
+	// A wildcard cell stands for several letters and a letter set spans
+	//   several characters, so boards with either are not compared cell by
+	//   cell; they get a full solve.
+	const int boardSize = nRows*nCols;
+	if ( pathBoard.empty() || !recordPaths || isConstrained || input.size() != size_t(boardSize)
+		|| input.find_first_of( "?[" ) != std::string::npos || pathBoard.find_first_of( "?[" ) != std::string::npos )
+	{
+		solve( input );
+		return;
+	}
+
+	std::vector<int> changed;
+	for ( int idx = 0; idx < boardSize; ++idx )
+	{
+		if ( input[idx] != pathBoard[idx] )
+		{
+			changed.push_back( idx );
+		}
+	}
+	if ( changed.empty() )
+	{
+		return;
+	}
+	pathBoard = input;
+	if ( !loadBoard( input ) )
+	{
+		solve( input );
+		return;
+	}
+	setAnchors( changed );
+
+	// Drop every word whose path used a changed cell, keeping it aside in
+	//   case another path still spells it.
+	std::vector<std::string> dropped;
+	for ( WordIterator::WordMap::iterator itr = wordsFound.begin(); itr != wordsFound.end(); )
+	{
+		const uint16_t* path = &paths[itr->second];
+		bool touched = false;
+		for ( size_t i = 0; i < itr->first.size() && !touched; ++i )
+		{
+			touched = isAnchor[path[i]];
+		}
+		if ( touched )
+		{
+			dropped.push_back( itr->first );
+			wordsFound.erase( itr++ );
+		}
+		else
+		{
+			++itr;
+		}
+	}
+
+	searchAnchors( changed );
+
+	// A dropped word not found through a changed cell may still be spelled
+	//   by a path that avoids them all.
+	for ( size_t w = 0; w < dropped.size(); ++w )
+	{
+		const std::string& word = dropped[w];
+		if ( wordsFound.count( word ) )
+		{
+			continue;
+		}
+		bool found = false;
+		for ( int idx = 0; idx < boardSize && !found; ++idx )
+		{
+			found = tracehelper( word, 0, idx );
+		}
+		if ( found )
+		{
+			const uint32_t at = paths.size();
+			paths.insert( paths.end(), &currentPath[0], &currentPath[0] + word.size() );
+			wordsFound.insert( std::make_pair( word, at ) );
+		}
+	}
+	compactPaths();
+}
+
+void WordHeroSolver::solveThrough( const std::string& input, int row, int col )
+{
+	wordsFound.clear();
+	paths.clear();
+	pathBoard.clear();
+	if ( !loadBoard( input ) || !isInBounds( row, col ) )
+	{
+		return;
+	}
+	std::vector<int> anchor( 1, row*nCols + col );
+	setAnchors( anchor );
+	searchAnchors( anchor );
+}
+
+// Marks the cells that anchored searches must pass through. The number of
+//   steps to the nearest one, found breadth-first over the topology (on a
+//   grid, the Chebyshev distance), is a lower bound on the letters a path
+//   that has not reached one yet still needs to get there.
+void WordHeroSolver::setAnchors( const std::vector<int>& cells )
+{
+	const int boardSize = nRows*nCols;
+	isAnchor.assign( boardSize, 0 );
+	anchorLetters = 0;
+	anchorDistance.assign( boardSize, boardSize );
+	std::vector<int> queue;
+	for ( size_t i = 0; i < cells.size(); ++i )
+	{
+		const char c = board[cells[i]].getChar();
+		isAnchor[cells[i]] = 1;
+		anchorLetters |= c >= 'A' && c <= 'Z' ? uint32_t(1) << (c - 'A') : 0;
+		anchorDistance[cells[i]] = 0;
+		queue.push_back( cells[i] );
+	}
+	for ( size_t i = 0; i < queue.size(); ++i )
+	{
+		const int cell = queue[i];
+		for ( const int* next = topology->neighbors( cell ); next != topology->neighborsEnd( cell ); ++next )
+		{
+			if ( anchorDistance[*next] > anchorDistance[cell] + 1 )
+			{
+				anchorDistance[*next] = anchorDistance[cell] + 1;
+				queue.push_back( *next );
+			}
+		}
+	}
+}
+
+// Adds every word with a path through one of the cells set by setAnchors.
+//   The GADDAG only knows DAWG words, so added words always take the forward
+//   search, which then skips the DAWG.
+void WordHeroSolver::searchAnchors( const std::vector<int>& cells )
+{
+	char str[MAX_STRING_LENGTH];
+	gaddag = dictionary->gaddag();
+	if ( gaddag )
+	{
+		// The word grows both ways from the middle of str.
+		const int middle = MAX_STRING_LENGTH/2;
+		for ( size_t i = 0; i < cells.size(); ++i )
+		{
+			const char c = board[cells[i]].getChar();
+			const int entryIdx = dictionary->gaddagEntryNode( c );
+			if ( !entryIdx )
+			{
+				continue;
+			}
+			anchorCell = cells[i];
+			str[middle] = c;
+			currentPath[middle] = cells[i];
+			board[cells[i]].setVisited();
+			gaddaghelper( str, middle, middle + 1, anchorCell, entryIdx, false );
+			board[cells[i]].setNotVisited();
+		}
+	}
+	if ( !gaddag || addedWords )
+	{
+		searchDawg = !gaddag;
+		for ( int idx = 0; idx < nRows*nCols; ++idx )
+		{
+			updatehelper( str, 0, idx, 0, 0, 0, false );
+		}
+		searchDawg = true;
+	}
+}
+
+// Rewrites the path arena without the paths of dropped words once they
+//   take up more than half of it.
+void WordHeroSolver::compactPaths()
+{
+	size_t live = 0;
+	for ( WordIterator::WordMap::const_iterator itr = wordsFound.begin(); itr != wordsFound.end(); ++itr )
+	{
+		live += itr->first.size();
+	}
+	if ( paths.size() <= 2*live )
+	{
+		return;
+	}
+	std::vector<uint16_t> compacted;
+	compacted.reserve( live );
+	for ( WordIterator::WordMap::iterator itr = wordsFound.begin(); itr != wordsFound.end(); ++itr )
+	{
+		const uint32_t at = compacted.size();
+		compacted.insert( compacted.end(), &paths[itr->second], &paths[itr->second] + itr->first.size() );
+		itr->second = at;
+	}
+	paths.swap( compacted );
+}
+
+// Copies wordsFound into the in-memory cache under cacheKey.
+void WordHeroSolver::storeInCache()
+{
+	if ( !cache )
+	{
+		return;
+	}
+	cacheValue.clear();
+	for ( WordIterator::WordMap::const_iterator itr = wordsFound.begin(); itr != wordsFound.end(); ++itr )
+	{
+		cacheValue += char(itr->first.size());
+		cacheValue += itr->first;
+	}
+	cache->insert( cacheKey, cacheValue );
+}
+void WordHeroSolver::summarize( const std::string& input, SolveSummary& result )
+{
+	memset( &result, 0, sizeof(result) );
+	if ( !loadBoard( input ) )
+	{
+		return;
+	}
+
+	// One bit per dictionary word, plus one per added-words trie node for
+	//   words that only the overlay knows. This only grows, so after the first
+	//   board with a given overlay nothing is allocated.
+	const size_t bits = dictionary->numberOfWords() + (addedWords ? addedWords->nodeCount() : 0);
+	if ( seenWords.size()*64 < bits )
+	{
+		seenWords.resize( (bits + 63) / 64 );
+	}
+	memset( &seenWords[0], 0, seenWords.size()*sizeof(uint64_t) );
+
+	char str[MAX_STRING_LENGTH];
+	summary = &result;
+	for ( int idx = 0; idx < nRows*nCols; ++idx )
+	{
+		summarizehelper( str, 0, idx, 0, 0, 0, 0 );
+	}
+	summary = NULL;
+}
+int WordHeroSolver::countWords( const std::string& input )
+{
+	SolveSummary result;
+	summarize( input, result );
+	return result.words;
+}
+uint64_t WordHeroSolver::score( const std::string& input )
+{
+	SolveSummary result;
+	summarize( input, result );
+	return result.score;
 }
-// TODO(ljdelight): dtor 
 
-void WordHeroSolver::solve( std::string input )
+bool WordHeroSolver::solveTopK( const std::string& input, int k, RankBy rankBy,
+				std::chrono::nanoseconds budget, std::vector<std::string>& words )
 {
-	const int MAX_STRING_LENGTH = 50;
-	wordsFound.clear();
-	for ( size_t i = 0; i < input.size(); ++i )
+	topDeadline = std::chrono::steady_clock::now() + budget;
+	topExpired = false;
+	topNodes = 0;
+	topWanted = std::max( k, 0 );
+	topFound.clear();
+	words.clear();
+	if ( !loadBoard( input ) )
+	{
+		return true;
+	}
+
+	for ( int length = 0; length < SolveSummary::MAX_LENGTH; ++length )
 	{
-		board[i] = Char( input[i] );
+		topValue[length] = rankBy == RANK_BY_SCORE ? scoreTable[length] : length;
+		topBound[length] = std::max( topValue[length], length ? topBound[length-1] : 0 );
 	}
 
+	// Best first: the start cells, and at every node the cells next to it,
+	//   are tried in order of the best word that could lie below them, so the
+	//   best words turn up early and tighten the pruning for the rest. Most
+	//   branches can still reach the longest words until a few letters from
+	//   the end, and ties keep the board order.
+	const int cells = nRows*nCols;
+	topSteps.resize( (MAX_STRING_LENGTH + 1)*topology->maxDegree() + cells );
+	TopStep* starts = &topSteps[MAX_STRING_LENGTH*topology->maxDegree()];
+	const int nStarts = orderSteps( 0, NULL, starts );
 	char str[MAX_STRING_LENGTH];
-	for ( int i = 0; i < nRows; ++i )
+	for ( int i = 0; i < nStarts && topWanted && !topExpired; ++i )
+	{
+		topkhelper( str, 0, starts[i] );
+	}
+	for ( std::set<RankedWord>::const_iterator itr = topFound.begin(); itr != topFound.end(); ++itr )
+	{
+		words.push_back( itr->word );
+	}
+	return !topExpired;
+}
+
+bool WordHeroSolver::isWord( const std::string& word ) const
+{
+	std::string upper( word );
+	for ( size_t i = 0; i < upper.size(); ++i )
 	{
-		for ( int j = 0; j < nCols; ++j )
+		upper[i] = toupper( upper[i] );
+	}
+	if ( int(upper.size()) < minWordLength || (isConstrained && !matchesAllConstraints( upper.data(), upper.size() ))
+		|| (bannedWords && bannedWords->contains( upper )) )
+	{
+		return false;
+	}
+	if ( addedWords && addedWords->contains( upper ) )
+	{
+		return true;
+	}
+	return dictionary->wordId( upper.data(), upper.size() ) >= 0;
+}
+
+void WordHeroSolver::verifyWords( const std::string& input, const std::vector<std::string>& words,
+				std::vector<WordCheck>& results )
+{
+	const bool isValid = loadBoard( input );
+
+	// The candidates go into a trie so shared prefixes are walked once.
+	//   candidatesLeft[t] counts the unfound candidates at or below node t; a
+	//   branch is abandoned as soon as everything below it has been traced.
+	//   Words with letters outside 'A'-'Z' never enter the trie.
+	candidates.clear();
+	for ( size_t i = 0; i < words.size(); ++i )
+	{
+		candidates.insert( words[i] );
+	}
+	candidatesLeft.assign( candidates.nodeCount(), 0 );
+	candidateFound.assign( candidates.nodeCount(), 0 );
+	for ( int trieIdx = candidates.nodeCount() - 1; trieIdx >= Trie::ROOT; --trieIdx )
+	{
+		// Children are always created after their parent, so a reverse sweep
+		//   has every child's count before it reaches the parent.
+		candidatesLeft[trieIdx] = (trieIdx != Trie::ROOT && candidates.isEndOfWord( trieIdx )) ? 1 : 0;
+		for ( char c = 'A'; c <= 'Z'; ++c )
 		{
-			solvehelper( str, 0, MAX_STRING_LENGTH, i, j );
+			int childIdx = candidates.child( trieIdx, c );
+			candidatesLeft[trieIdx] += childIdx ? candidatesLeft[childIdx] : 0;
 		}
 	}
+
+	candidatePath.clear();
+	for ( int idx = 0; isValid && idx < nRows*nCols && candidatesLeft[Trie::ROOT]; ++idx )
+	{
+		verifyhelper( idx, Trie::ROOT );
+	}
+
+	results.resize( words.size() );
+	for ( size_t i = 0; i < words.size(); ++i )
+	{
+		int trieIdx = candidates.find( words[i] );
+		results[i].onBoard = trieIdx && trieIdx != Trie::ROOT && candidateFound[trieIdx];
+		results[i].inDictionary = isWord( words[i] );
+	}
 }
-std::set<std::string>::const_iterator WordHeroSolver::begin() const
+
+WordHeroSolver::const_iterator WordHeroSolver::begin() const
 { 
-	return wordsFound.begin(); 
+	return const_iterator( wordsFound.begin(), &paths ); 
 }
-std::set<std::string>::const_iterator WordHeroSolver::end() const
+WordHeroSolver::const_iterator WordHeroSolver::end() const
 { 
-	return wordsFound.end(); 
+	return const_iterator( wordsFound.end(), &paths ); 
 }
 
-bool WordHeroSolver::isInBounds( int x, int y )
+// Steps the DAWG walk and the added- and banned-word walks onto letter c
+//   together: to their entry nodes when a word starts with c (strLen 0),
+//   otherwise to the child for c, or 0 where a walk has none. Returns false
+//   once neither the DAWG nor the added words go on.
+inline bool WordHeroSolver::stepLetter( char c, int strLen, int& dawgIdx, int& addIdx, int& banIdx ) const
 {
-	return (x>=0 && x<nRows && y>=0 && y<nCols);
+	if ( strLen == 0 )
+	{
+		dawgIdx = searchDawg ? dictionary->entryNode( c ) : 0;
+		addIdx = addedWords ? addedWords->child( Trie::ROOT, c ) : 0;
+		banIdx = bannedWords ? bannedWords->child( Trie::ROOT, c ) : 0;
+		return dawgIdx || addIdx;
+	}
+	// A zero dawgIdx means only the added-words trie is still alive. The
+	//   child list is sorted, so the child's place on it is the number of
+	//   lower child letters.
+	const uint32_t choices = dawgIdx ? dictionary->childLetters( dawgIdx ) : 0;
+	const uint32_t bit = c >= 'A' && c <= 'Z' ? uint32_t(1) << (c - 'A') : 0;
+	dawgIdx = (choices & bit) ? DAWG_CHILD(dawg, dawgIdx) + __builtin_popcount( choices & (bit - 1) ) : 0;
+	addIdx = addIdx ? addedWords->child( addIdx, c ) : 0;
+	banIdx = banIdx ? bannedWords->child( banIdx, c ) : 0;
+	return dawgIdx || addIdx;
 }
-bool WordHeroSolver::isValidCell( int x, int y )
+
+// solvehelper for update(): only words whose path uses a changed cell are
+//   reported. A branch that has not used one yet is cut once the nearest is
+//   farther away than the longest word below its DAWG node, or when no word
+//   below it contains any changed cell's letter.
+void WordHeroSolver::updatehelper( char* str, int strLen, int idx, int dawgIdx,
+				int addIdx, int banIdx, bool throughAnchor )
 {
-	return isInBounds(x,y) && ! board[x*nCols+y].isVisited();
+	if ( board[idx].isVisited() )
+	{
+		return;
+	}
+
+	char theCurrentChar = board[idx].getChar();
+	if ( !stepLetter( theCurrentChar, strLen, dawgIdx, addIdx, banIdx ) )
+	{
+		return;
+	}
+	throughAnchor = throughAnchor || isAnchor[idx];
+	if ( dawgIdx && !throughAnchor && (dictionary->maxDepthBelow( dawgIdx ) < anchorDistance[idx]
+			|| !(dictionary->lettersBelow( dawgIdx ) & anchorLetters)) )
+	{
+		// Added words have no depth data, so only the DAWG side is cut.
+		dawgIdx = 0;
+	}
+	// Added words have no length limit; stop where str runs out.
+	if ( (!dawgIdx && !addIdx) || strLen + 2 >= MAX_STRING_LENGTH )
+	{
+		return;
+	}
+
+	str[strLen] = theCurrentChar;
+	currentPath[strLen] = idx;
+	board[idx].setVisited();
+	strLen += 1;
+
+	const bool isWord = (dawgIdx && DAWG_END_OF_WORD(dawg, dawgIdx))
+			|| (addIdx && addedWords->isEndOfWord(addIdx));
+	const bool isBanned = banIdx && bannedWords->isEndOfWord(banIdx);
+	if ( throughAnchor && isWord && !isBanned )
+	{
+		reportWord( str, strLen, &currentPath[0] );
+	}
+
+	for ( const int* next = topology->neighbors( idx ); next != topology->neighborsEnd( idx ); ++next )
+	{
+		updatehelper( str, strLen, *next, dawgIdx, addIdx, banIdx, throughAnchor );
+	}
+
+	strLen -= 1;
+	board[idx].setNotVisited();
 }
 
+// Grows the word in str[begin,end), spelled so far by GADDAG node
+//   gaddagIdx, from its end cell idx: leftward by prepending letters, then,
+//   past the separator, rightward from the anchor by appending them. A node
+//   that ends a word means the word is complete in both directions.
+void WordHeroSolver::gaddaghelper( char* str, int begin, int end, int idx,
+				int gaddagIdx, bool rightward )
+{
+	if ( DAWG_END_OF_WORD(gaddag, gaddagIdx)
+		&& !(bannedWords && bannedWords->contains( std::string( str + begin, end - begin ) )) )
+	{
+		reportWord( str + begin, end - begin, &currentPath[begin] );
+	}
 
-void WordHeroSolver::solvehelper( char* str, int strLen, const int maxStrLen,
-				int x, int y, int dawgIdx )
+	const int at = rightward ? end : begin - 1;
+	const int childIdx = DAWG_CHILD(gaddag, gaddagIdx);
+	const bool hasRoom = childIdx && at >= 0 && at < int(currentPath.size());
+	for ( const int* next = topology->neighbors( idx ); next != topology->neighborsEnd( idx ) && hasRoom; ++next )
+	{
+		const char theCurrentChar = board[*next].getChar();
+		if ( board[*next].isVisited() || theCurrentChar < 'A' || theCurrentChar > 'Z' )
+		{
+			continue;
+		}
+		int nextIdx = childIdx;
+		while ( nextIdx && DAWG_LETTER(gaddag, nextIdx) != theCurrentChar )
+		{
+			nextIdx = DAWG_NEXT(gaddag, nextIdx);
+		}
+		if ( !nextIdx )
+		{
+			continue;
+		}
+		str[at] = theCurrentChar;
+		currentPath[at] = *next;
+		board[*next].setVisited();
+		gaddaghelper( str, rightward ? begin : at, rightward ? end + 1 : end,
+				*next, nextIdx, rightward );
+		board[*next].setNotVisited();
+	}
+
+	if ( !rightward )
+	{
+		// The separator is the last letter of the builder's character set,
+		//   so it ends every list it is on.
+		int separatorIdx = childIdx;
+		while ( separatorIdx && DAWG_LETTER(gaddag, separatorIdx) != GADDAG_SEPARATOR )
+		{
+			separatorIdx = DAWG_NEXT(gaddag, separatorIdx);
+		}
+		if ( separatorIdx )
+		{
+			gaddaghelper( str, begin, end, anchorCell, separatorIdx, true );
+		}
+	}
+}
+
+// Adds a word found by an anchored search, with its path when recorded.
+void WordHeroSolver::reportWord( const char* str, int strLen, const uint16_t* path )
 {
-	if ( ! isValidCell( x, y ) )
+	if ( strLen < minWordLength || (isConstrained && !matchesAllConstraints( str, strLen )) )
 	{
 		return;
 	}
+	if ( viewMode )
+	{
+		storeView( str, strLen );
+		return;
+	}
+	std::pair<WordIterator::WordMap::iterator, bool> inserted
+			= wordsFound.insert( std::make_pair( std::string( str, strLen ), WordIterator::NO_PATH ) );
+	if ( inserted.second && recordPaths )
+	{
+		inserted.first->second = paths.size();
+		paths.insert( paths.end(), path, path + strLen );
+	}
+	SOLVER_COUNT( inserted.second ? ++counterValues.wordsFound : ++counterValues.duplicateHits );
+}
 
-	int idx = x*nCols + y;
-	char theCurrentChar = board[idx].getChar();
+// Follows word's letters from letter strLen at cell idx, leaving the
+//   cells in currentPath. A trace that starts inside the word, at letter
+//   start, runs to the end of the word and then from the start cell back to
+//   the first letter.
+bool WordHeroSolver::tracehelper( const std::string& word, int strLen, int idx, int start )
+{
+	if ( board[idx].isVisited() || board[idx].getChar() != word[strLen] )
+	{
+		return false;
+	}
+	currentPath[strLen] = idx;
+	int next = strLen + 1, from = idx;
+	if ( strLen < start || next == int(word.size()) )
+	{
+		next = std::min( strLen, start ) - 1;
+		from = strLen < start ? idx : currentPath[start];
+	}
+	if ( next < 0 )
+	{
+		return true;
+	}
+	board[idx].setVisited();
+	bool found = false;
+	for ( const int* cell = topology->neighbors( from ); cell != topology->neighborsEnd( from ) && !found; ++cell )
+	{
+		found = tracehelper( word, next, *cell, start );
+	}
+	board[idx].setNotVisited();
+	return found;
+}
 
-	// strLen==0 when we're starting a new word.
-	if ( strLen == 0 )
+// Whether any word through DAWG node dawgIdx (whose letter c is about to
+//   become str[strLen]) can meet the length and letter constraints.
+bool WordHeroSolver::canSatisfy( const char* str, int strLen, char c, int dawgIdx ) const
+{
+	if ( strLen + 1 + dictionary->maxDepthBelow( dawgIdx ) < minWordLength )
 	{
-		// The DAWG indices for 'A'-'Z' are on [1,26] which is one-based.
-		dawgIdx = theCurrentChar - 'A' + 1;
+		return false;
 	}
-	else
+	const char letter = constraints.letter;
+	return !letter || c == letter || memchr( str, letter, strLen )
+		|| (dictionary->lettersBelow( dawgIdx ) & requiredLetterBit);
+}
+
+bool WordHeroSolver::matchesConstraints( const char* str, int strLen ) const
+{
+	const std::string& suffix = constraints.suffix;
+	if ( !suffix.empty() && memcmp( str + strLen - suffix.size(), suffix.data(), suffix.size() ) != 0 )
+	{
+		return false;
+	}
+	return !constraints.letter || memchr( str, constraints.letter, strLen );
+}
+
+// matchesConstraints plus the prefix and maximum length, which solvehelper
+//   enforces during its walk but anchored searches can only check at the end.
+bool WordHeroSolver::matchesAllConstraints( const char* str, int strLen ) const
+{
+	const std::string& prefix = constraints.prefix;
+	if ( (constraints.maxLength && strLen > constraints.maxLength) || int(prefix.size()) > strLen
+		|| memcmp( str, prefix.data(), prefix.size() ) != 0 )
+	{
+		return false;
+	}
+	return matchesConstraints( str, strLen );
+}
+
+// Fills steps with the ways a topK path can go from step (or start, if
+//   step is NULL), best bound first, and returns how many there are. Ties
+//   keep the neighbor order. Dead ends and branches that cannot beat the
+//   worst word in hand are left out.
+int WordHeroSolver::orderSteps( int strLen, const TopStep* step, TopStep* steps ) const
+{
+	const int* next = step ? topology->neighbors( step->idx ) : NULL;
+	const int* end = step ? topology->neighborsEnd( step->idx ) : NULL;
+	const int count = step ? end - next : nRows*nCols;
+	const bool isFull = topFound.size() >= topWanted;
+	int n = 0;
+	for ( int i = 0; i < count; ++i )
+	{
+		TopStep candidate;
+		candidate.idx = step ? next[i] : i;
+		if ( board[candidate.idx].isVisited() )
+		{
+			continue;
+		}
+		candidate.dawgIdx = step ? step->dawgIdx : 0;
+		candidate.addIdx = step ? step->addIdx : 0;
+		candidate.banIdx = step ? step->banIdx : 0;
+		if ( !stepLetter( board[candidate.idx].getChar(), strLen, candidate.dawgIdx,
+				candidate.addIdx, candidate.banIdx ) )
+		{
+			continue;
+		}
+		// Added words carry no depth information, so only a pure DAWG branch
+		//   can be bounded: nothing below it is longer than maxDepthBelow more
+		//   letters.
+		const int longest = strLen + 1 + dictionary->maxDepthBelow( candidate.dawgIdx );
+		candidate.bound = candidate.addIdx ? INT_MAX : topBound[std::min( longest, SolveSummary::MAX_LENGTH - 1 )];
+		if ( isFull && candidate.bound < topFound.rbegin()->value )
+		{
+			continue;
+		}
+		int at = n++;
+		for ( ; at > 0 && steps[at-1].bound < candidate.bound; --at )
+		{
+			steps[at] = steps[at-1];
+		}
+		steps[at] = candidate;
+	}
+	return n;
+}
+
+// solvehelper that keeps only the topWanted best words, skips branches that
+//   cannot produce a better one and tries the most promising branch first.
+//   step is this cell and the trie nodes its letter reaches.
+void WordHeroSolver::topkhelper( char* str, int strLen, const TopStep& step )
+{
+	// The worst word in hand may have improved since step was ordered.
+	if ( topExpired || (topFound.size() >= topWanted && step.bound < topFound.rbegin()->value) )
+	{
+		return;
+	}
+	// Reading the clock on every node would cost more than the node itself.
+	if ( (++topNodes & 255) == 0 && std::chrono::steady_clock::now() >= topDeadline )
+	{
+		topExpired = true;
+		return;
+	}
+
+	if ( strLen + 2 >= MAX_STRING_LENGTH )
+	{
+		return;
+	}
+
+	str[strLen] = board[step.idx].getChar();
+	board[step.idx].setVisited();
+	strLen += 1;
+
+	const bool isWord = (step.dawgIdx && DAWG_END_OF_WORD(dawg, step.dawgIdx))
+			|| (step.addIdx && addedWords->isEndOfWord(step.addIdx));
+	const bool isBanned = step.banIdx && bannedWords->isEndOfWord(step.banIdx);
+	if ( strLen >= minWordLength && isWord && !isBanned && (!isConstrained || matchesAllConstraints( str, strLen )) )
+	{
+		RankedWord ranked = { topValue[std::min( strLen, SolveSummary::MAX_LENGTH - 1 )], std::string( str, strLen ) };
+		if ( topFound.size() < topWanted || ranked < *topFound.rbegin() )
+		{
+			topFound.insert( ranked );
+			if ( topFound.size() > topWanted )
+			{
+				topFound.erase( --topFound.end() );
+			}
+		}
+	}
+
+	// Each depth orders its steps in its own slice of topSteps.
+	TopStep* steps = &topSteps[(strLen - 1)*topology->maxDegree()];
+	const int n = orderSteps( strLen, &step, steps );
+	for ( int i = 0; i < n; ++i )
+	{
+		topkhelper( str, strLen, steps[i] );
+	}
+
+	strLen -= 1;
+	board[step.idx].setNotVisited();
+}
+
+bool WordHeroSolver::isInBounds( int x, int y )
+{
+	return (x>=0 && x<nRows && y>=0 && y<nCols);
+}
+
+
+void WordHeroSolver::solvehelper( char* str, int strLen, const int maxStrLen,
+				int idx, int dawgIdx, int addIdx, int banIdx )
+{
+	if ( board[idx].isVisited() )
 	{
-		// The DAWG_CHILD is a list of chars that can follow the previous char.
-		//    Search the list to see if the char was found (making a valid prefix)
-		dawgIdx = DAWG_CHILD(dawg, dawgIdx);
-		while ( dawgIdx && DAWG_LETTER(dawg, dawgIdx) != theCurrentChar )
+		SOLVER_COUNT( ++counterValues.visitedRejects );
+		return;
+	}
+
+	if ( board[idx].isWildcard() )
+	{
+		// Try each letter the cell allows that can extend the prefix: a DAWG
+		//   child, unless the added-words trie may accept others too.
+		uint32_t choices = board[idx].letterSet();
+		if ( strLen > 0 && !addIdx )
 		{
-			dawgIdx = DAWG_NEXT(dawg, dawgIdx);
+			choices &= dawgIdx ? dictionary->childLetters( dawgIdx ) : 0;
 		}
-		// if the char was not found then we have an INVALID prefix! stop recursion
-		if ( !dawgIdx )
+		for ( ; choices; choices &= choices - 1 )
+		{
+			board[idx].setChar( 'A' + __builtin_ctz( choices ) );
+			solvehelper( str, strLen, maxStrLen, idx, dawgIdx, addIdx, banIdx );
+		}
+		board[idx].setChar( Char::WILDCARD );
+		return;
+	}
+	char theCurrentChar = board[idx].getChar();
+
+	if ( isConstrained && strLen < int(constraints.prefix.size())
+		&& theCurrentChar != constraints.prefix[strLen] )
+	{
+		return;
+	}
+
+#ifdef WORDHERO_COUNTERS
+	if ( strLen > 0 && dawgIdx )
+	{
+		// The entries a scan of the DAWG child list would inspect to find
+		//   the letter, or the whole list and its end when it is not there.
+		const uint32_t choices = dictionary->childLetters( dawgIdx );
+		const uint32_t bit = theCurrentChar >= 'A' && theCurrentChar <= 'Z' ? uint32_t(1) << (theCurrentChar - 'A') : 0;
+		const int scanLength = 1 + __builtin_popcount( (choices & bit) ? choices & (bit - 1) : choices );
+		counterValues.siblingScans += 1;
+		counterValues.siblingSteps += scanLength;
+		counterValues.scanLengths[std::min( scanLength, SolverCounters::MAX_SCAN - 1 )] += 1;
+	}
+#endif
+	// if the char was not found then we have an INVALID prefix! stop recursion
+	if ( !stepLetter( theCurrentChar, strLen, dawgIdx, addIdx, banIdx ) )
+	{
+		SOLVER_COUNT( counterValues.pruneDepths[std::min( strLen, SolverCounters::MAX_DEPTH - 1 )] += 1 );
+		return;
+	}
+	if ( isConstrained && dawgIdx && !canSatisfy( str, strLen, theCurrentChar, dawgIdx ) )
+	{
+		// Only the added-words trie, which has no depth data, can still match.
+		dawgIdx = 0;
+		if ( !addIdx )
 		{
 			return;
 		}
 	}
 
 	// we must have the board's character equal to the dawgIdx char value.
-	assert( theCurrentChar == DAWG_LETTER(dawg,dawgIdx) );
+	assert( !dawgIdx || theCurrentChar == DAWG_LETTER(dawg,dawgIdx) );
+
+	// strLen is the number of readable chars (excluding terminating)
+	//   So strLen must always be on the range [0,maxStrLen-1). DAWG words
+	//   never come close, but added words have no length limit.
+	if ( strLen + 2 >= maxStrLen )
+	{
+		return;
+	}
+
+	SOLVER_COUNT( counterValues.nodesExpanded += 1 );
 
 	// place the character in the string
 	str[strLen] = theCurrentChar;
+	currentPath[strLen] = idx;
 	board[idx].setVisited();
 	strLen += 1;
 
-	// strLen is the number of readable chars (excluding terminating)
-	//   So strLen must always be on the range [0,maxStrLen-1)
-	assert( strLen < maxStrLen-1 );
-
-	if ( strLen>=3 && DAWG_END_OF_WORD(dawg, dawgIdx) )
+	bool isWord = (dawgIdx && DAWG_END_OF_WORD(dawg, dawgIdx))
+			|| (addIdx && addedWords->isEndOfWord(addIdx));
+	bool isBanned = banIdx && bannedWords->isEndOfWord(banIdx);
+	const bool isReported = strLen>=minWordLength && isWord && !isBanned
+		&& (!isConstrained || matchesConstraints( str, strLen ));
+	if ( isReported && viewMode )
+	{
+		storeView( str, strLen );
+	}
+	else if ( isReported )
 	{
 		str[strLen] = '\0';
-		wordsFound.insert(str);
+		std::pair<WordIterator::WordMap::iterator, bool> inserted
+				= wordsFound.insert( std::make_pair( std::string( str ), WordIterator::NO_PATH ) );
+		// Only the first path found for a word is kept.
+		if ( inserted.second && recordPaths )
+		{
+			inserted.first->second = paths.size();
+			paths.insert( paths.end(), &currentPath[0], &currentPath[0] + strLen );
+		}
+		SOLVER_COUNT( inserted.second ? ++counterValues.wordsFound : ++counterValues.duplicateHits );
+	}
+	if ( isConstrained && strLen == constraints.maxLength )
+	{
+		strLen -= 1;
+		board[idx].setNotVisited();
+		return;
 	}
 
-	solvehelper( str, strLen, maxStrLen, x-1, y-1, dawgIdx );  // upper-left
-	solvehelper( str, strLen, maxStrLen, x-1, y,   dawgIdx );  // upper-center
-	solvehelper( str, strLen, maxStrLen, x-1, y+1, dawgIdx );  // upper-right
-	solvehelper( str, strLen, maxStrLen, x,   y-1, dawgIdx );  // left
-	solvehelper( str, strLen, maxStrLen, x,   y+1, dawgIdx );  // right
-	solvehelper( str, strLen, maxStrLen, x+1, y-1, dawgIdx );  // bottom-left
-	solvehelper( str, strLen, maxStrLen, x+1, y,   dawgIdx );  // bottom-center
-	solvehelper( str, strLen, maxStrLen, x+1, y+1, dawgIdx );  // bottom-right
+	// Every neighbor, in the topology's order (on a grid: upper-left,
+	//   upper-center, upper-right, left, right, bottom-left, bottom-center,
+	//   bottom-right).
+	for ( const int* next = topology->neighbors( idx ); next != topology->neighborsEnd( idx ); ++next )
+	{
+		solvehelper( str, strLen, maxStrLen, *next, dawgIdx, addIdx, banIdx );
+	}
 
 	// remove the char from the string and set to unvisited
 	strLen -= 1;
 	board[idx].setNotVisited();
-}
\ No newline at end of file
+}
+
+// The same walk as solvehelper, but instead of storing the word it carries
+//   the word's Dictionary id: rank counts every word that sorts before the
+//   current prefix, so when the prefix is a word its id is exactly rank.
+//   str only holds the letters for the constraints.
+void WordHeroSolver::summarizehelper( char* str, int strLen, int idx, int dawgIdx, int rank,
+				int addIdx, int banIdx )
+{
+	if ( board[idx].isVisited() )
+	{
+		return;
+	}
+
+	const int parentIdx = dawgIdx;
+	if ( !stepLetter( board[idx].getChar(), strLen, dawgIdx, addIdx, banIdx ) )
+	{
+		return;
+	}
+	if ( dawgIdx )
+	{
+		rank = dictionary->rankStep( strLen ? parentIdx : 0, rank, dawgIdx );
+	}
+	if ( strLen + 2 >= MAX_STRING_LENGTH )
+	{
+		return;
+	}
+
+	str[strLen] = board[idx].getChar();
+	board[idx].setVisited();
+	strLen += 1;
+
+	const bool inDawg = dawgIdx && DAWG_END_OF_WORD(dawg, dawgIdx);
+	const bool inAdded = addIdx && addedWords->isEndOfWord(addIdx);
+	const bool isBanned = banIdx && bannedWords->isEndOfWord(banIdx);
+	if ( strLen >= minWordLength && (inDawg || inAdded) && !isBanned
+		&& (!isConstrained || matchesAllConstraints( str, strLen )) )
+	{
+		const size_t bit = inDawg ? rank : dictionary->numberOfWords() + addIdx;
+		uint64_t& seen = seenWords[bit / 64];
+		const uint64_t mask = uint64_t(1) << (bit % 64);
+		if ( !(seen & mask) )
+		{
+			seen |= mask;
+			const int length = std::min( strLen, SolveSummary::MAX_LENGTH - 1 );
+			summary->words += 1;
+			summary->wordsByLength[length] += 1;
+			summary->score += scoreTable[length];
+			summary->scoreByLength[length] += scoreTable[length];
+		}
+	}
+
+	for ( const int* next = topology->neighbors( idx ); next != topology->neighborsEnd( idx ); ++next )
+	{
+		summarizehelper( str, strLen, *next, dawgIdx, rank, addIdx, banIdx );
+	}
+
+	board[idx].setNotVisited();
+}
+
+
+// Board walk driven by the candidate trie: only neighbours whose letter
+//   continues some unfound candidate are visited.
+void WordHeroSolver::verifyhelper( int idx, int trieIdx )
+{
+	if ( board[idx].isVisited() )
+	{
+		return;
+	}
+	trieIdx = candidates.child( trieIdx, board[idx].getChar() );
+	if ( !trieIdx || !candidatesLeft[trieIdx] )
+	{
+		return;
+	}
+
+	board[idx].setVisited();
+	candidatePath.push_back( trieIdx );
+
+	if ( candidates.isEndOfWord( trieIdx ) && !candidateFound[trieIdx] )
+	{
+		candidateFound[trieIdx] = 1;
+		candidatesLeft[Trie::ROOT] -= 1;
+		for ( size_t i = 0; i < candidatePath.size(); ++i )
+		{
+			candidatesLeft[candidatePath[i]] -= 1;
+		}
+	}
+
+	for ( const int* next = topology->neighbors( idx );
+		next != topology->neighborsEnd( idx ) && candidatesLeft[trieIdx]; ++next )
+	{
+		verifyhelper( *next, trieIdx );
+	}
+
+	candidatePath.pop_back();
+	board[idx].setNotVisited();
+}
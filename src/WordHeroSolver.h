@@ -3,10 +3,22 @@
 #define _WORDHEROSOLVER_H
 
 #include "Char.h"
+#include "Trie.h"
+#include "Dictionary.h"
+#include "SolverCounters.h"
+#include "ResultCache.h"
+#include "DiskCache.h"
+#include "Topology.h"
 #include <string>
 #include <set>
+#include <map>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+#include <chrono>
 #include <iostream>
 #include <cassert>
+#include <stdint.h>
 
 struct sortByStringLength {
     bool operator() (const std::string& lhs, const std::string& rhs) const{
@@ -23,27 +35,450 @@ struct sortByStringLength {
     }
 };
 
+// Totals for a board without the words themselves (see WordHeroSolver::summarize).
+//   Words longer than MAX_LENGTH-1 letters are tallied in the last bucket.
+struct SolveSummary
+{
+	static const int MAX_LENGTH = 32;
+
+	uint32_t words;
+	uint64_t score;
+	uint32_t wordsByLength[MAX_LENGTH];
+	uint64_t scoreByLength[MAX_LENGTH];
+};
+
+// Narrows what solve() reports (see WordHeroSolver::setConstraints). An empty
+//   string, a zero maxLength or a '\0' letter leaves that part unconstrained.
+struct SolveConstraints
+{
+	int minLength;
+	int maxLength;
+	std::string prefix;
+	std::string suffix;
+	char letter;   // every word must contain this letter
+
+	SolveConstraints() : minLength(3), maxLength(0), letter('\0') {}
+};
+
+// Per-candidate answer from WordHeroSolver::verifyWords.
+struct WordCheck
+{
+	bool onBoard;       // traceable through adjacent cells, each used once
+	bool inDictionary;  // solve() would report it: DAWG or added words, not banned, meets the constraints
+};
+
+// The words of the last solve, shortest first. When the solver records
+//   paths, path() gives the cells (row*cols + col) of one way to swipe the
+//   word, one per letter; otherwise it returns NULL.
+class WordIterator
+{
+public:
+	typedef std::map<std::string, uint32_t, sortByStringLength> WordMap;
+	static const uint32_t NO_PATH = 0xffffffff;
+
+	typedef std::bidirectional_iterator_tag iterator_category;
+	typedef std::string value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const std::string* pointer;
+	typedef const std::string& reference;
+
+	WordIterator() : paths(NULL) {}
+	WordIterator( WordMap::const_iterator itr, const std::vector<uint16_t>* paths )
+		: itr(itr), paths(paths) {}
+
+	reference operator*() const { return itr->first; }
+	pointer operator->() const { return &itr->first; }
+	WordIterator& operator++() { ++itr; return *this; }
+	WordIterator operator++( int ) { WordIterator old( *this ); ++itr; return old; }
+	WordIterator& operator--() { --itr; return *this; }
+	WordIterator operator--( int ) { WordIterator old( *this ); --itr; return old; }
+	bool operator==( const WordIterator& other ) const { return itr == other.itr; }
+	bool operator!=( const WordIterator& other ) const { return itr != other.itr; }
+
+	const uint16_t* path() const
+	{
+		return itr->second == NO_PATH ? NULL : &(*paths)[itr->second];
+	}
+private:
+	WordMap::const_iterator itr;
+	const std::vector<uint16_t>* paths;
+};
+
+// A word of WordHeroSolver::solveView: its letters in the solver's arena,
+//   without a terminating '\0'. Valid until the solver's next solve.
+class WordView
+{
+public:
+	WordView() : letters(NULL), length(0) {}
+	WordView( const char* letters, size_t length ) : letters(letters), length(length) {}
+
+	const char* data() const { return letters; }
+	size_t size() const { return length; }
+	std::string str() const { return std::string( letters, length ); }
+private:
+	const char* letters;
+	size_t length;
+};
+
+// The words of a solveView, contiguous and in solve() order.
+class WordSpan
+{
+public:
+	WordSpan() : first(NULL), last(NULL) {}
+	WordSpan( const WordView* first, const WordView* last ) : first(first), last(last) {}
+
+	const WordView* begin() const { return first; }
+	const WordView* end() const { return last; }
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+	const WordView& operator[]( size_t i ) const { return first[i]; }
+private:
+	const WordView* first;
+	const WordView* last;
+};
+
 class WordHeroSolver 
 {
 public:
 	WordHeroSolver( int NRows = 4, int NCols = 4 );
-	// TODO(ljdelight): dtor 
+	// Share an already loaded dictionary; it must outlive the solver.
+	WordHeroSolver( const Dictionary& dictionary, int NRows = 4, int NCols = 4 );
+	~WordHeroSolver();
+
+	int rows() const { return nRows; }
+	int cols() const { return nCols; }
+
+	// Overlay runtime word lists on the DAWG without rebuilding it. A word is
+	//   reported if it is in (DAWG or added) and not in banned. Either trie may
+	//   be NULL; the tries are not owned and must outlive the solver.
+	void setOverlay( const Trie* added, const Trie* banned );
+	// Solve on another board layout (see Topology), such as hexagonal,
+	//   wraparound, irregular or 3D boards. It must have rows()*cols() cells;
+	//   returns false otherwise. Every search and engine follows its neighbor
+	//   lists. The topology is not owned and must outlive the solver; NULL
+	//   restores the grid. The caches' keys assume a grid, so solves on
+	//   another layout bypass them.
+	bool setTopology( const Topology* topology );
+
+	typedef WordIterator const_iterator;
+
+	// Solves a board given row by row, one character per cell. A '?' cell is
+	//   a wildcard for any letter, and a cell written as a bracketed set such
+	//   as [AEIOU] is one for the letters listed. The search tries each
+	//   allowed letter that continues a DAWG prefix; the letter a wildcard
+	//   took is the word's letter at that cell of its path. Wildcard boards
+	//   use the board engine and bypass the caches. update() falls back to a
+	//   full solve for them; the other queries below treat wildcard cells as
+	//   blanks. A board without exactly rows*cols
+	//   cells has no words, here and in the queries below.
+	void solve( const std::string& input );
+	// Upper-cases a board written as solve() reads it and returns how many
+	//   cells it has, or -1 if it holds anything but letters, '?' and
+	//   bracketed sets of letters. The servers and the C ABI check boards
+	//   with it.
+	static int countCells( std::string& input );
+	const_iterator begin() const;
+	const_iterator end() const;
+	// solve() without allocating per word, for many solver threads sharing
+	//   one heap. The board is read in place and the words are packed into
+	//   arenas the solver reuses, so once they have grown to fit the largest
+	//   result, a solve allocates nothing. Bypasses the caches and records
+	//   no paths; begin() and end() are left empty.
+	WordSpan solveView( const char* input, size_t length );
+	// The search solve() runs. ENGINE_BOARD starts at every cell and follows
+	//   the DAWG (solvehelper). ENGINE_DICTIONARY walks the DAWG once,
+	//   extending the board paths that spell each prefix, starting from each
+	//   letter's list of cells; once only one word is left below a prefix, it
+	//   stops at that word's first path. It wins on large boards with a small
+	//   lexicon, like a themed list on a 200x200 grid. On larger boards,
+	//   ENGINE_AUTO (the default) estimates the cost of both engines from the
+	//   board's letter counts.
+	//   ENGINE_FRONTIER runs breadth-first by word length on boards of at most
+	//   64 cells. It keeps each prefix's paths as (end cell, visited cells)
+	//   states, so paths that differ only in the order they visited the same
+	//   cells merge into one state. It is about 2.5x faster than the board
+	//   engine on small boards, and 4-5x when letters repeat heavily, so
+	//   ENGINE_AUTO uses it on every board that fits. Added words,
+	//   constraints and boards over 65536 cells always use the board engine.
+	//   ENGINE_INTERLEAVED is experimental: the board engine's search from
+	//   several start cells at once, where each walk prefetches the DAWG node
+	//   of its next step and yields to the next walk, so their cache misses
+	//   can overlap. It is only used when set. On the hosts measured so far,
+	//   one walk ran as fast as eight; its speedup over the board engine
+	//   comes from stepping to a child with Dictionary::childLetters and
+	//   dropping repeated words by id, not from the overlap.
+	enum Engine { ENGINE_AUTO, ENGINE_BOARD, ENGINE_DICTIONARY, ENGINE_FRONTIER, ENGINE_INTERLEAVED };
+	void setEngine( Engine engine ) { this->engine = engine; }
+	// The engine the last solve() searched with (ENGINE_AUTO if it searched nothing).
+	Engine lastEngine() const { return usedEngine; }
+	// Serve solve() from a cache shared with other solvers (NULL for none).
+	//   Solves with recorded paths, constraints or overlays bypass it.
+	void setCache( ResultCache* cache ) { this->cache = cache; }
+	// A persistent cache consulted after the in-memory one; boards found there
+	//   are copied into the in-memory cache. Bypassed like the in-memory one.
+	void setDiskCache( DiskCache* cache ) { diskCache = cache; }
+	// Limits later solves to words matching the constraints (NULL clears them).
+	//   They prune the search itself: the prefix is matched cell by cell, and a
+	//   DAWG branch is cut once no word below it can reach the minimum length
+	//   or still contain the required letter.
+	void setConstraints( const SolveConstraints* constraints );
+	// Keep one swipe path per word (see WordIterator::path). The paths share a
+	//   single per-solver arena, so recording adds no allocation per word.
+	//   Boards must have at most 65536 cells.
+	void setRecordPaths( bool record ) { recordPaths = record; }
+	// Re-solves after some tiles changed, starting from the last result. The
+	//   cells where input differs from the last board are found by comparison.
+	//   Words whose stored path used a changed cell are dropped, only paths
+	//   through a changed cell are searched for new words (as solveThrough
+	//   does, so a loaded GADDAG speeds this up too), and dropped words
+	//   are traced again in case another path still spells them. Needs the last
+	//   solve to have recorded paths without constraints, and neither board
+	//   to have wildcards; otherwise this is a full solve.
+	void update( const std::string& input );
+	// solve() for one tile of a larger grid: every word with a path that
+	//   starts in rows [top, bottom) and columns [left, right). The cells
+	//   around that region only continue paths (see TiledSolver); words that
+	//   start there may be reported too. Bypasses the caches, and update()
+	//   cannot continue from it.
+	void solveRegion( const std::string& input, int top, int left, int bottom, int right );
+	// Every word with a path through cell (row, col), for hints and
+	//   highlighting; it replaces the last result like solve(). With a GADDAG
+	//   loaded (see Dictionary::loadGaddag) each word is grown outward from
+	//   the anchor, leftward and then rightward, so only paths through it are
+	//   walked. Without one, this is a forward search pruned like update()'s.
+	void solveThrough( const std::string& input, int row, int col );
 
-	void solve( std::string input );
-	std::set<std::string>::const_iterator begin() const;
-	std::set<std::string>::const_iterator end() const;
+	// Count-only/score-only solving. Nothing is allocated and no strings are
+	//   built: each word is deduplicated by its Dictionary id (tracked during the
+	//   walk), since DAWG terminal nodes are shared by many words. Counts the
+	//   words solve() would report, constraints included.
+	void summarize( const std::string& input, SolveSummary& summary );
+	int countWords( const std::string& input );
+	uint64_t score( const std::string& input );
+	// Points for a word of each length; lengths past the table score like the
+	//   last entry. The default is the classic Boggle table.
+	void setScoreTable( const int* pointsByLength, int n );
+
+	// Anytime solving under a hard time budget. Returns up to k words, best
+	//   first: longest first, or highest scoring first (see setScoreTable),
+	//   then longer, then alphabetical. The search is best first: start cells
+	//   and next cells are tried in order of the longest word a DAWG branch
+	//   could hold (Dictionary::maxDepthBelow), and once k words are in hand,
+	//   any branch that cannot beat the worst of them is pruned. Words are
+	//   filtered by setConstraints like solve(). Returns false if the budget
+	//   ran out; words then holds the best words found so far.
+	enum RankBy { RANK_BY_LENGTH, RANK_BY_SCORE };
+	bool solveTopK( const std::string& input, int k, RankBy rankBy,
+				std::chrono::nanoseconds budget, std::vector<std::string>& words );
+
+	// Checks submitted words against a board without a full solve. The search
+	//   follows only the candidates' letters, and candidates that share a prefix
+	//   share the board walk for it. results[i] answers candidates[i].
+	void verifyWords( const std::string& input, const std::vector<std::string>& candidates,
+				std::vector<WordCheck>& results );
+	bool isWord( const std::string& word ) const;
+
+	// Instrumentation for the last solve; all zero unless built with
+	//   WORDHERO_COUNTERS (see SolverCounters.h).
+	const SolverCounters& counters() const { return counterValues; }
 private:
 	int nRows;
 	int nCols;
 	Char* board;
-	int* dawg;
-	std::set<std::string, sortByStringLength> wordsFound;
-	const int MAX_STRING_LENGTH = 50;
+	// The layout being solved: gridTopology unless setTopology chose another.
+	Topology gridTopology;
+	const Topology* topology;
+	Dictionary* ownedDictionary;
+	const Dictionary* dictionary;
+	const int* dawg;
+	const Trie* addedWords;
+	const Trie* bannedWords;
+	WordIterator::WordMap wordsFound;
+	bool recordPaths;
+	ResultCache* cache;
+	std::string cacheKey;
+	std::string cacheValue;
+	DiskCache* diskCache;
+	std::vector<uint32_t> cacheIds;
+	bool isConstrained;
+	// Whether the loaded board has wildcard cells (see solve).
+	bool hasWildcards;
+	SolveConstraints constraints;
+	int minWordLength;
+	uint32_t requiredLetterBit;
+	std::vector<uint16_t> paths;
+	std::vector<uint16_t> currentPath;
+	// The board the current paths belong to (empty if update() cannot reuse them).
+	std::string pathBoard;
+	std::vector<int> anchorDistance;
+	std::vector<char> isAnchor;
+	uint32_t anchorLetters;
+	// solveThrough and update state: the GADDAG and the anchor being searched.
+	const int* gaddag;
+	int anchorCell;
+	bool searchDawg;
+	SolverCounters counterValues;
+	Engine engine;
+	Engine usedEngine;
+	// The cells solve() starts words from; the whole board except during solveRegion().
+	int regionTop, regionLeft, regionBottom, regionRight;
+	// Dictionary engine state. letterCells holds the cells of each letter,
+	//   those of letter c on [letterStart[c-'A'], letterStart[c-'A'+1]).
+	//   pathLevels[d] holds every board path spelling the current prefix of
+	//   d+1 letters; each step names the one before it on level d-1.
+	struct PathStep
+	{
+		int cell;
+		int parent;
+	};
+	std::vector<int> letterCells;
+	int letterStart[27];
+	std::vector<std::vector<PathStep> > pathLevels;
+	std::vector<PathStep> letterBuckets[26];
+	std::string chainWord;
+	// Frontier engine state. frontierLevels[d] holds the states of every
+	//   prefix of d+1 letters, deduplicated within each prefix; each state
+	//   names one state it came from on level d-1. frontierGroups[d] holds
+	//   each prefix's DAWG node and range of states.
+	struct FrontierState
+	{
+		uint64_t visited;
+		int cell;
+		int parent;
+		bool operator<( const FrontierState& other ) const
+		{
+			return visited != other.visited ? visited < other.visited : cell < other.cell;
+		}
+		bool operator==( const FrontierState& other ) const
+		{
+			return visited == other.visited && cell == other.cell;
+		}
+	};
+	struct FrontierGroup
+	{
+		int dawgIdx;
+		int begin;
+		int end;
+	};
+	std::vector<std::vector<FrontierState> > frontierLevels;
+	std::vector<std::vector<FrontierGroup> > frontierGroups;
+	// Bit i of neighborMasks[cell] is set if cell i is adjacent to it, and of
+	//   letterMasks[c] if cell i holds letter 'A'+c.
+	std::vector<uint64_t> neighborMasks;
+	uint64_t letterMasks[26];
+	// Interleaved engine state: one depth-first walk per context, each with
+	//   its own stack, word and visited cells. A walk's next step waits in
+	//   nextCell and nextIdx while its node is prefetched. ranks[d] is the
+	//   Dictionary id of the prefix ending at nodes[d] (see summarizehelper),
+	//   and nextNeighbor[d] the place in its cell's neighbor list to go on from.
+	struct Walk
+	{
+		static const int MAX_DEPTH = 48;
+		int depth;
+		int nextCell;
+		int nextIdx;
+		int nodes[MAX_DEPTH];
+		int ranks[MAX_DEPTH];
+		int nextNeighbor[MAX_DEPTH];
+		char str[MAX_DEPTH];
+		uint16_t path[MAX_DEPTH];
+		std::vector<uint64_t> visited;
+	};
+	std::vector<Walk> walks;
+	// solveView state. While viewMode is set, words go to wordArena instead
+	//   of wordsFound. viewTable is an open-addressing set of arenaWords
+	//   indices plus one (0 is empty) that drops repeated words.
+	struct ArenaWord
+	{
+		uint32_t offset;
+		uint32_t size;
+	};
+	bool viewMode;
+	std::vector<char> wordArena;
+	std::vector<ArenaWord> arenaWords;
+	std::vector<uint32_t> viewTable;
+	std::vector<WordView> wordViews;
+	int scoreTable[SolveSummary::MAX_LENGTH];
+	std::vector<uint64_t> seenWords;
+	SolveSummary* summary;
+	Trie candidates;
+	std::vector<int> candidatesLeft;
+	std::vector<char> candidateFound;
+	std::vector<int> candidatePath;
+	static const int MAX_STRING_LENGTH = 50;
+
+	// solveTopK state: the best words so far, best first.
+	struct RankedWord
+	{
+		int value;
+		std::string word;
+		bool operator<( const RankedWord& other ) const
+		{
+			if ( value != other.value ) return value > other.value;
+			if ( word.size() != other.word.size() ) return word.size() > other.word.size();
+			return word < other.word;
+		}
+	};
+	std::set<RankedWord> topFound;
+	size_t topWanted;
+	int topValue[SolveSummary::MAX_LENGTH];  // value of a word of each length
+	int topBound[SolveSummary::MAX_LENGTH];  // best value of any word up to each length
+	bool topExpired;
+	// One way a topK path can go next: the cell, the trie nodes its letter
+	//   reaches and the best value of any word below.
+	struct TopStep
+	{
+		int bound;
+		int idx;
+		int dawgIdx;
+		int addIdx;
+		int banIdx;
+	};
+	std::vector<TopStep> topSteps;
+	unsigned topNodes;
+	std::chrono::steady_clock::time_point topDeadline;
+
+	WordHeroSolver( const WordHeroSolver& ) = delete;
+	WordHeroSolver& operator=( const WordHeroSolver& ) = delete;
 
+	void init();
+	bool loadBoard( const char* input, size_t length );
+	bool loadBoard( const std::string& input ) { return loadBoard( input.data(), input.size() ); }
+	void searchBoard();
+	void storeView( const char* str, int strLen );
+	void storeInCache();
+	Engine chooseEngine();
+	void estimatehelper( int listIdx, int depth, double parentPaths, double& boardCost, double& dictionaryCost );
+	void indexLetters();
+	void dictionaryhelper( char* str, int depth, int listIdx, int aboveBegin, int aboveEnd );
+	void markPath( int depth, int step, bool visited );
+	bool findChain( int depth, int dawgIdx, int begin, int end );
+	void reportPath( int depth, int step );
+	void frontierhelper();
+	void reportState( int depth, int state );
+	void interleavedhelper();
+	bool advanceWalk( Walk& walk );
+	bool stepLetter( char c, int strLen, int& dawgIdx, int& addIdx, int& banIdx ) const;
 	bool isInBounds( int x, int y );
-	bool isValidCell( int x, int y );
 	void solvehelper( char* str, int strLen, const int maxStrLen,
-					int x, int y, int dawgIdx = 0 );
+					int idx, int dawgIdx = 0,
+					int addIdx = 0, int banIdx = 0 );
+	void updatehelper( char* str, int strLen, int idx, int dawgIdx,
+					int addIdx, int banIdx, bool throughAnchor );
+	bool tracehelper( const std::string& word, int strLen, int idx, int start = 0 );
+	void compactPaths();
+	void setAnchors( const std::vector<int>& cells );
+	void searchAnchors( const std::vector<int>& cells );
+	void gaddaghelper( char* str, int begin, int end, int idx, int gaddagIdx, bool rightward );
+	void reportWord( const char* str, int strLen, const uint16_t* path );
+	bool canSatisfy( const char* str, int strLen, char c, int dawgIdx ) const;
+	bool matchesConstraints( const char* str, int strLen ) const;
+	bool matchesAllConstraints( const char* str, int strLen ) const;
+	void summarizehelper( char* str, int strLen, int idx, int dawgIdx, int rank,
+					int addIdx, int banIdx );
+	int orderSteps( int strLen, const TopStep* step, TopStep* steps ) const;
+	void topkhelper( char* str, int strLen, const TopStep& step );
+	void verifyhelper( int idx, int trieIdx );
 };
 
 #endif
@@ -24,10 +24,45 @@
 #include <string>
 #include <fstream>
 #include <set>
+#include <unistd.h>
+#include <csignal>
+#include <chrono>
 
 #include "WordHeroSolver.h"
+#include "Dictionary.h"
+#include "SolverServer.h"
+#include "ShmTransport.h"
+#include "ResultWriter.h"
+#include "Metrics.h"
+#include "Trie.h"
+#include "TiledSolver.h"
+#include "Topology.h"
 using namespace std;
 
+static SolverServer* theServer = NULL;
+static ShmSolverServer* theShmServer = NULL;
+
+static void stopServer( int )
+{
+	if ( theServer )
+	{
+		theServer->stop();
+	}
+	if ( theShmServer )
+	{
+		theShmServer->stop();
+	}
+}
+
+static void usage( const char* program )
+{
+	cerr << "usage: " << program << " [-a added-words.txt] [-b banned-words.txt] [-r rows] [-c cols]\n"
+		 << "       [-s socket-path] [-p port] [-t threads] [-m shm-name] [-o ids|strings|json]\n"
+		 << "       [-w] [-k cache-MB] [-d cache-file] [-i stats-seconds] [-e metrics.prom]\n"
+		 << "       [-g grid.txt|- [-l tile-size]] [-y grid|torus|hex|cube]" << endl;
+	exit(1);
+}
+
 int main( int argc, char* argv[] )
 {
 	//
@@ -54,7 +89,331 @@ int main( int argc, char* argv[] )
 //		cout << *itr << '\n';
 //	}
 
-	WordHeroSolver solver;
+	Trie addedWords, bannedWords;
+	bool hasAdded = false, hasBanned = false;
+	int nRows = 4, nCols = 4;
+	const char* socketPath = NULL;
+	const char* shmName = NULL;
+	const char* outputFormat = NULL;
+	bool withPaths = false;
+	int cacheMegabytes = 0;
+	const char* cacheFile = NULL;
+	int statsInterval = 0;
+	const char* prometheusFile = NULL;
+	int port = 0;
+	int threads = 1;
+	const char* gridFile = NULL;
+	int tileSize = 192;
+	const char* layout = "grid";
+	int opt;
+	while ( (opt = getopt( argc, argv, "a:b:r:c:s:p:t:m:o:wk:d:i:e:g:l:y:" )) != -1 )
+	{
+		switch ( opt )
+		{
+		case 'a':
+			hasAdded = addedWords.load( optarg );
+			if ( !hasAdded )
+			{
+				cerr << "could not read the added words file " << optarg << endl;
+				exit(1);
+			}
+			break;
+		case 'b':
+			hasBanned = bannedWords.load( optarg );
+			if ( !hasBanned )
+			{
+				cerr << "could not read the banned words file " << optarg << endl;
+				exit(1);
+			}
+			break;
+		case 'r':
+			nRows = atoi( optarg );
+			break;
+		case 'c':
+			nCols = atoi( optarg );
+			break;
+		case 's':
+			socketPath = optarg;
+			break;
+		case 'p':
+			port = atoi( optarg );
+			break;
+		case 't':
+			threads = atoi( optarg );
+			break;
+		case 'm':
+			shmName = optarg;
+			break;
+		case 'o':
+			outputFormat = optarg;
+			break;
+		case 'w':
+			withPaths = true;
+			break;
+		case 'k':
+			cacheMegabytes = atoi( optarg );
+			break;
+		case 'd':
+			cacheFile = optarg;
+			break;
+		case 'i':
+			statsInterval = atoi( optarg );
+			break;
+		case 'e':
+			prometheusFile = optarg;
+			break;
+		case 'g':
+			gridFile = optarg;
+			break;
+		case 'l':
+			tileSize = atoi( optarg );
+			break;
+		case 'y':
+			layout = optarg;
+			break;
+		default:
+			usage( argv[0] );
+		}
+	}
+	if ( nRows <= 0 || nCols <= 0 || tileSize <= 0 )
+	{
+		usage( argv[0] );
+	}
+	// Shared memory answers are dictionary word ids from one solver that
+	//   skips the caches and metrics, so no other option would take effect.
+	if ( shmName && (hasAdded || cacheMegabytes > 0 || cacheFile || statsInterval > 0 || prometheusFile
+		|| outputFormat || withPaths || gridFile || socketPath || port) )
+	{
+		cerr << "-m can only be combined with -b, -r, -c and -y" << endl;
+		exit(1);
+	}
+
+	// The board layout; a cube of side -c is -c*-c rows of layers.
+	Topology topology;
+	if ( !strcmp( layout, "torus" ) )
+	{
+		topology = Topology::torus( nRows, nCols );
+	}
+	else if ( !strcmp( layout, "hex" ) )
+	{
+		topology = Topology::hex( nRows, nCols );
+	}
+	else if ( !strcmp( layout, "cube" ) )
+	{
+		if ( nRows != nCols*nCols )
+		{
+			cerr << "-y cube needs -r to be the square of -c" << endl;
+			exit(1);
+		}
+		topology = Topology::cube( nCols );
+	}
+	else if ( strcmp( layout, "grid" ) )
+	{
+		usage( argv[0] );
+	}
+	const Topology* theTopology = strcmp( layout, "grid" ) ? &topology : NULL;
+	if ( theTopology && gridFile )
+	{
+		cerr << "-y cannot be combined with -g" << endl;
+		exit(1);
+	}
+
+	Dictionary dictionary;
+	if ( !dictionary.load( "dictionary.dat" ) )
+	{
+		cerr << "could not initialize the DAWG (bad file?)" << endl;
+		exit(1);
+	}
+
+	// Repeated boards, and rotations and reflections of them, are answered
+	//   from memory instead of solved again.
+	ResultCache cache( size_t(cacheMegabytes > 0 ? cacheMegabytes : 0) << 20 );
+	ResultCache* theCache = cacheMegabytes > 0 ? &cache : NULL;
+
+	// Solved boards persist across restarts, stored by word id.
+	DiskCache diskCache;
+	if ( cacheFile )
+	{
+		if ( hasAdded || hasBanned )
+		{
+			cerr << "-d cannot be combined with -a or -b" << endl;
+			exit(1);
+		}
+		if ( !diskCache.open( cacheFile, dictionary ) )
+		{
+			cerr << "could not open the cache file " << cacheFile << endl;
+			exit(1);
+		}
+	}
+	DiskCache* theDiskCache = cacheFile ? &diskCache : NULL;
+
+	SolverMetrics metrics;
+	metrics.setCache( theCache );
+	metrics.setDiskCache( theDiskCache );
+	const bool hasMetrics = statsInterval > 0 || prometheusFile;
+	if ( hasMetrics )
+	{
+		// Without -i the Prometheus file is refreshed every 10 seconds.
+		metrics.startReporting( statsInterval > 0 ? statsInterval : 10,
+					statsInterval > 0 ? &cerr : NULL, prometheusFile ? prometheusFile : "" );
+	}
+
+	//
+	// DAEMON MODE: SERVE BOARDS UNTIL SIGINT/SIGTERM.
+	//
+	if ( socketPath || port )
+	{
+		SolverServer server( dictionary, nRows, nCols, threads );
+		server.setOverlay( hasAdded ? &addedWords : NULL, hasBanned ? &bannedWords : NULL );
+		server.setTopology( theTopology );
+		server.setMetrics( hasMetrics ? &metrics : NULL );
+		server.setCache( theCache );
+		server.setDiskCache( theDiskCache );
+		if ( socketPath && !server.listenUnix( socketPath ) )
+		{
+			cerr << "could not listen on " << socketPath << endl;
+			exit(1);
+		}
+		if ( port && !server.listenTcp( port ) )
+		{
+			cerr << "could not listen on localhost port " << port << endl;
+			exit(1);
+		}
+		theServer = &server;
+		signal( SIGINT, stopServer );
+		signal( SIGTERM, stopServer );
+		signal( SIGPIPE, SIG_IGN );
+		server.run();
+		theServer = NULL;
+		metrics.stop();
+		return 0;
+	}
+
+	//
+	// SHARED MEMORY MODE: SERVE ONE LOCAL CLIENT UNTIL SIGINT/SIGTERM.
+	//
+	if ( shmName )
+	{
+		ShmSolverServer server( dictionary, nRows, nCols );
+		server.setTopology( theTopology );
+		server.setBanned( hasBanned ? &bannedWords : NULL );
+		if ( !server.create( shmName ) )
+		{
+			cerr << "could not create the shared memory segment " << shmName << endl;
+			exit(1);
+		}
+		theShmServer = &server;
+		signal( SIGINT, stopServer );
+		signal( SIGTERM, stopServer );
+		server.run();
+		theShmServer = NULL;
+		return 0;
+	}
+
+	//
+	// LARGE GRID MODE: STREAM ONE BIG GRID FROM A FILE AND SOLVE IT IN TILES.
+	//
+	if ( gridFile )
+	{
+		ifstream file;
+		if ( strcmp( gridFile, "-" ) )
+		{
+			file.open( gridFile );
+			if ( !file )
+			{
+				cerr << "could not read the grid file " << gridFile << endl;
+				exit(1);
+			}
+		}
+		TiledSolver tiled( dictionary, tileSize, threads );
+		tiled.setOverlay( hasAdded ? &addedWords : NULL, hasBanned ? &bannedWords : NULL );
+		if ( !tiled.solve( strcmp( gridFile, "-" ) ? file : cin ) )
+		{
+			cerr << "the rows of the grid are not all the same width" << endl;
+			exit(1);
+		}
+		TiledSolver::WordSet::const_iterator itr = tiled.words().begin(), end = tiled.words().end();
+		for ( ; itr != end; ++itr )
+		{
+			cout << *itr << '\n';
+		}
+		return 0;
+	}
+
+	WordHeroSolver solver( dictionary, nRows, nCols );
+	solver.setOverlay( hasAdded ? &addedWords : NULL, hasBanned ? &bannedWords : NULL );
+	solver.setTopology( theTopology );
+	solver.setCache( theCache );
+	solver.setDiskCache( theDiskCache );
+
+	//
+	// BATCH MODE: ONE BOARD PER LINE, NO PROMPTS, BUFFERED OUTPUT.
+	//
+	if ( outputFormat )
+	{
+		ResultWriter::Format format;
+		if ( !strcmp( outputFormat, "ids" ) )
+		{
+			// Words from an added-words overlay have no dictionary id.
+			if ( hasAdded )
+			{
+				cerr << "-o ids cannot be combined with -a" << endl;
+				exit(1);
+			}
+			format = ResultWriter::BINARY_IDS;
+		}
+		else if ( !strcmp( outputFormat, "strings" ) )
+		{
+			format = ResultWriter::BINARY_STRINGS;
+		}
+		else if ( !strcmp( outputFormat, "json" ) )
+		{
+			format = ResultWriter::JSON;
+			solver.setRecordPaths( withPaths );
+		}
+		else
+		{
+			usage( argv[0] );
+		}
+		if ( withPaths && format != ResultWriter::JSON )
+		{
+			cerr << "-w needs -o json" << endl;
+			exit(1);
+		}
+
+		ResultWriter writer( STDOUT_FILENO, format, dictionary );
+		string input;
+		uint64_t boardId = 0;
+		while ( getline( cin,input ) )
+		{
+			// A short or malformed line would otherwise be solved with the
+			//   previous board's trailing cells; report it and move on.
+			if ( WordHeroSolver::countCells( input ) != nRows*nCols )
+			{
+				cerr << "board " << boardId++ << ": expected " << nRows*nCols << " cells" << endl;
+				continue;
+			}
+			chrono::steady_clock::time_point start = chrono::steady_clock::now();
+			solver.solve(input);
+			chrono::steady_clock::time_point solved = chrono::steady_clock::now();
+			writer.writeBoard( boardId++, input, solver );
+			if ( hasMetrics )
+			{
+				metrics.recordBoard( chrono::duration_cast<chrono::nanoseconds>( solved - start ).count(),
+							distance( solver.begin(), solver.end() ) );
+				metrics.outputNs.record( chrono::duration_cast<chrono::nanoseconds>(
+							chrono::steady_clock::now() - solved ).count() );
+			}
+			// Hand results over as soon as there is no more input queued up, so a
+			//   line-at-a-time caller is never left waiting on the buffer.
+			if ( cin.rdbuf()->in_avail() <= 0 && !writer.flush() )
+			{
+				exit(1);
+			}
+		}
+		metrics.stop();
+		return writer.flush() ? 0 : 1;
+	}
 	
 	//
 	// ASK FOR THE BOARD AND SOLVE IT. REPEAT.
@@ -63,8 +422,14 @@ int main( int argc, char* argv[] )
 	cout << "Enter board: " << endl;
 	while ( getline( cin,input ) )
 	{
+		if ( WordHeroSolver::countCells( input ) != nRows*nCols )
+		{
+			cerr << "expected " << nRows*nCols << " cells" << endl;
+			cout << "Enter board:" << endl;
+			continue;
+		}
 		solver.solve(input);
-		set<string>::const_iterator itr = solver.begin(), end = solver.end();
+		WordHeroSolver::const_iterator itr = solver.begin(), end = solver.end();
 		for ( ; itr != end; ++itr )
 		{
 			cout << *itr << '\n';
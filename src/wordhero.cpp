@@ -0,0 +1,273 @@
+
+#include "wordhero.h"
+#include "WordHeroSolver.h"
+#include "Dictionary.h"
+#include <string>
+#include <vector>
+#include <cstring>
+#include <new>
+
+struct wh_dictionary
+{
+	Dictionary dictionary;
+};
+
+struct wh_solver
+{
+	WordHeroSolver solver;
+	std::string board;
+	std::vector<std::string> words;
+	std::vector<WordCheck> checks;
+
+	wh_solver( const Dictionary& dictionary, int rows, int cols )
+		: solver(dictionary, rows, cols) {}
+};
+
+
+int wh_abi_version( void )
+{
+	return WORDHERO_ABI_VERSION;
+}
+
+wh_dictionary* wh_dictionary_open( const char* path )
+{
+	if ( !path )
+	{
+		return NULL;
+	}
+	wh_dictionary* result = new (std::nothrow) wh_dictionary;
+	try
+	{
+		if ( result && !result->dictionary.load( path ) )
+		{
+			delete result;
+			result = NULL;
+		}
+	}
+	catch ( const std::bad_alloc& )
+	{
+		delete result;
+		result = NULL;
+	}
+	return result;
+}
+
+void wh_dictionary_close( wh_dictionary* dictionary )
+{
+	delete dictionary;
+}
+
+int wh_dictionary_load_gaddag( wh_dictionary* dictionary, const char* path )
+{
+	if ( !dictionary || !path )
+	{
+		return WH_ERR_INVALID_ARGUMENT;
+	}
+	try
+	{
+		return dictionary->dictionary.loadGaddag( path ) ? WH_OK : WH_ERR_BAD_FILE;
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return WH_ERR_OUT_OF_MEMORY;
+	}
+}
+
+uint32_t wh_dictionary_word_count( const wh_dictionary* dictionary )
+{
+	return dictionary ? dictionary->dictionary.numberOfWords() : 0;
+}
+
+wh_solver* wh_solver_create( const wh_dictionary* dictionary, int rows, int cols )
+{
+	if ( !dictionary || rows <= 0 || cols <= 0 )
+	{
+		return NULL;
+	}
+	try
+	{
+		return new wh_solver( dictionary->dictionary, rows, cols );
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return NULL;
+	}
+}
+
+void wh_solver_destroy( wh_solver* solver )
+{
+	delete solver;
+}
+
+// Copies the board into solver->board in upper case; false if it has the
+//   wrong number of cells or a character solve() does not read (see
+//   WordHeroSolver::countCells). assign() reuses the solver's buffer, so
+//   this only allocates on first use.
+static bool loadBoard( wh_solver* solver, const char* board, size_t length )
+{
+	solver->board.assign( board, length );
+	return WordHeroSolver::countCells( solver->board ) == solver->solver.rows()*solver->solver.cols();
+}
+
+// Packs the words [itr, end) into buffer.
+template <typename Iterator>
+static int packResults( Iterator itr, Iterator end, char* buffer, size_t bufferSize, wh_results* results )
+{
+	size_t needed = 0;
+	uint32_t count = 0;
+	for ( ; itr != end; ++itr, ++count )
+	{
+		const size_t wordBytes = itr->size() + 2;
+		if ( needed + wordBytes <= bufferSize )
+		{
+			buffer[needed] = char(itr->size());
+			memcpy( buffer + needed + 1, itr->data(), itr->size() );
+			buffer[needed + wordBytes - 1] = '\0';
+		}
+		needed += wordBytes;
+	}
+	results->bytes = needed;
+	if ( needed > bufferSize )
+	{
+		return WH_ERR_BUFFER_TOO_SMALL;
+	}
+	results->count = count;
+	return WH_OK;
+}
+
+int wh_solve( wh_solver* solver, const char* board, size_t length,
+			char* buffer, size_t bufferSize, wh_results* results )
+{
+	if ( !solver || !board || !results || (!buffer && bufferSize) )
+	{
+		return WH_ERR_INVALID_ARGUMENT;
+	}
+	results->data = buffer;
+	results->bytes = 0;
+	results->count = 0;
+
+	try
+	{
+		if ( !loadBoard( solver, board, length ) )
+		{
+			return WH_ERR_BAD_BOARD;
+		}
+		// The arena-backed solve allocates nothing once warmed up.
+		WordSpan words = solver->solver.solveView( solver->board.data(), solver->board.size() );
+		return packResults( words.begin(), words.end(), buffer, bufferSize, results );
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return WH_ERR_OUT_OF_MEMORY;
+	}
+}
+
+int wh_solve_through( wh_solver* solver, const char* board, size_t length, int row, int col,
+			char* buffer, size_t bufferSize, wh_results* results )
+{
+	if ( !solver || !board || !results || (!buffer && bufferSize) )
+	{
+		return WH_ERR_INVALID_ARGUMENT;
+	}
+	results->data = buffer;
+	results->bytes = 0;
+	results->count = 0;
+	if ( row < 0 || row >= solver->solver.rows() || col < 0 || col >= solver->solver.cols() )
+	{
+		return WH_ERR_INVALID_ARGUMENT;
+	}
+
+	try
+	{
+		if ( !loadBoard( solver, board, length ) )
+		{
+			return WH_ERR_BAD_BOARD;
+		}
+		solver->solver.solveThrough( solver->board, row, col );
+		return packResults( solver->solver.begin(), solver->solver.end(), buffer, bufferSize, results );
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return WH_ERR_OUT_OF_MEMORY;
+	}
+}
+
+int wh_summarize( wh_solver* solver, const char* board, size_t length, wh_summary* summary )
+{
+	if ( !solver || !board || !summary )
+	{
+		return WH_ERR_INVALID_ARGUMENT;
+	}
+	memset( summary, 0, sizeof(*summary) );
+	try
+	{
+		if ( !loadBoard( solver, board, length ) )
+		{
+			return WH_ERR_BAD_BOARD;
+		}
+		SolveSummary result;
+		solver->solver.summarize( solver->board, result );
+		summary->words = result.words;
+		summary->score = result.score;
+		for ( int i = 0; i < WH_SUMMARY_MAX_LENGTH && i < SolveSummary::MAX_LENGTH; ++i )
+		{
+			summary->words_by_length[i] = result.wordsByLength[i];
+			summary->score_by_length[i] = result.scoreByLength[i];
+		}
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return WH_ERR_OUT_OF_MEMORY;
+	}
+	return WH_OK;
+}
+
+int wh_verify( wh_solver* solver, const char* board, size_t length,
+			const char* const* words, size_t count, uint8_t* flags )
+{
+	if ( !solver || !board || ((!words || !flags) && count) )
+	{
+		return WH_ERR_INVALID_ARGUMENT;
+	}
+	try
+	{
+		if ( !loadBoard( solver, board, length ) )
+		{
+			return WH_ERR_BAD_BOARD;
+		}
+		solver->words.resize( count );
+		for ( size_t i = 0; i < count; ++i )
+		{
+			solver->words[i].assign( words[i] ? words[i] : "" );
+		}
+		solver->solver.verifyWords( solver->board, solver->words, solver->checks );
+		for ( size_t i = 0; i < count; ++i )
+		{
+			flags[i] = (solver->checks[i].onBoard ? WH_ON_BOARD : 0)
+				| (solver->checks[i].inDictionary ? WH_IN_DICTIONARY : 0);
+		}
+	}
+	catch ( const std::bad_alloc& )
+	{
+		return WH_ERR_OUT_OF_MEMORY;
+	}
+	return WH_OK;
+}
+
+void wh_results_begin( const wh_results* results, wh_iterator* itr )
+{
+	itr->next = results->data;
+	itr->end = results->data + (results->count ? results->bytes : 0);
+}
+
+int wh_results_next( wh_iterator* itr, const char** word, size_t* length )
+{
+	if ( itr->next >= itr->end )
+	{
+		return 0;
+	}
+	*length = (unsigned char)itr->next[0];
+	*word = itr->next + 1;
+	itr->next += *length + 2;
+	return 1;
+}
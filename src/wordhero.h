@@ -0,0 +1,128 @@
+/*
+ * C ABI for embedding the solver (libwordhero.so / libwordhero.a).
+ *
+ * Handles are opaque and the structs below only ever grow at the end, so a
+ *   program built against WORDHERO_ABI_VERSION keeps working with newer
+ *   libraries. No function throws or exits; errors come back as WH_ERR_*.
+ *
+ *   wh_dictionary* dict = wh_dictionary_open( "dictionary.dat" );
+ *   wh_solver* solver = wh_solver_create( dict, 4, 4 );
+ *   char buffer[1 << 16];
+ *   wh_results results;
+ *   if ( wh_solve( solver, "HAGOLLBRISEMMETW", 16, buffer, sizeof(buffer), &results ) == WH_OK )
+ *   {
+ *       wh_iterator itr;
+ *       const char* word;
+ *       size_t length;
+ *       wh_results_begin( &results, &itr );
+ *       while ( wh_results_next( &itr, &word, &length ) ) puts( word );
+ *   }
+ *   wh_solver_destroy( solver );
+ *   wh_dictionary_close( dict );
+ */
+
+#ifndef _WORDHERO_H
+#define _WORDHERO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WORDHERO_ABI_VERSION 1
+
+#if defined(__GNUC__)
+#define WH_API __attribute__((visibility("default")))
+#else
+#define WH_API
+#endif
+
+enum
+{
+	WH_OK = 0,
+	WH_ERR_INVALID_ARGUMENT = -1,
+	WH_ERR_BAD_BOARD = -2,
+	WH_ERR_BUFFER_TOO_SMALL = -3,
+	WH_ERR_OUT_OF_MEMORY = -4,
+	WH_ERR_BAD_FILE = -5
+};
+
+typedef struct wh_dictionary wh_dictionary;
+typedef struct wh_solver wh_solver;
+
+/* Words are packed into the caller's buffer as [length byte][letters]['\0']. */
+typedef struct wh_results
+{
+	const char* data;
+	size_t bytes;
+	uint32_t count;
+} wh_results;
+
+/* Counts and scores only; see wh_summarize. Index i of the by-length arrays
+ *   holds words of i letters (the last entry also holds anything longer). */
+#define WH_SUMMARY_MAX_LENGTH 32
+typedef struct wh_summary
+{
+	uint32_t words;
+	uint64_t score;
+	uint32_t words_by_length[WH_SUMMARY_MAX_LENGTH];
+	uint64_t score_by_length[WH_SUMMARY_MAX_LENGTH];
+} wh_summary;
+
+typedef struct wh_iterator
+{
+	const char* next;
+	const char* end;
+} wh_iterator;
+
+WH_API int wh_abi_version( void );
+
+/* Returns NULL if the file cannot be read, is corrupt or does not fit in memory. */
+WH_API wh_dictionary* wh_dictionary_open( const char* path );
+WH_API void wh_dictionary_close( wh_dictionary* dictionary );
+/* Loads gaddag.dat ('make gaddag.dat'), built from the same word list, so
+ *   wh_solve_through grows words outward from the tapped cell. Call it before
+ *   any solver using the dictionary runs. */
+WH_API int wh_dictionary_load_gaddag( wh_dictionary* dictionary, const char* path );
+WH_API uint32_t wh_dictionary_word_count( const wh_dictionary* dictionary );
+
+/* The dictionary must outlive every solver created from it. A dictionary
+ *   can be shared by solvers on different threads; a solver cannot. */
+WH_API wh_solver* wh_solver_create( const wh_dictionary* dictionary, int rows, int cols );
+WH_API void wh_solver_destroy( wh_solver* solver );
+
+/* Solves a rows*cols board (letters A-Z, any case; '?' for any letter and
+ *   [AEIOU] for one of the letters listed) into buffer. On
+ *   WH_ERR_BUFFER_TOO_SMALL, results->bytes holds the size that is needed. */
+WH_API int wh_solve( wh_solver* solver, const char* board, size_t length,
+			char* buffer, size_t bufferSize, wh_results* results );
+
+/* Like wh_solve, but only the words with a path through cell (row, col),
+ *   for hints and highlighting. Fastest with a GADDAG loaded (see
+ *   wh_dictionary_load_gaddag); without one it still avoids a full solve. */
+WH_API int wh_solve_through( wh_solver* solver, const char* board, size_t length, int row, int col,
+			char* buffer, size_t bufferSize, wh_results* results );
+
+/* Word count and classic Boggle score of a board without producing any
+ *   words. Does not allocate once the solver has seen its first board. */
+WH_API int wh_summarize( wh_solver* solver, const char* board, size_t length, wh_summary* summary );
+
+/* Checks count NUL-terminated words against a board without a full solve.
+ *   flags[i] gets WH_ON_BOARD and/or WH_IN_DICTIONARY for words[i]; a word
+ *   is a valid play when both are set. */
+#define WH_ON_BOARD 1
+#define WH_IN_DICTIONARY 2
+WH_API int wh_verify( wh_solver* solver, const char* board, size_t length,
+			const char* const* words, size_t count, uint8_t* flags );
+
+WH_API void wh_results_begin( const wh_results* results, wh_iterator* itr );
+/* Returns 0 once every word has been visited. word is NUL terminated. */
+WH_API int wh_results_next( wh_iterator* itr, const char** word, size_t* length );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,765 @@
+/*
+ * Checks for the solver's query modes. Run with 'make check'; every check
+ *   that fails is printed, and the exit status is the number of failures.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <iterator>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "../src/WordHeroSolver.h"
+#include "../src/Dictionary.h"
+#include "../src/Dawg.h"
+#include "../src/ResultCache.h"
+#include "../src/DiskCache.h"
+#include "../src/Trie.h"
+#include "../src/Topology.h"
+#include "../src/TiledSolver.h"
+#include "../src/BatchSolver.h"
+#include "../src/ShmTransport.h"
+#include "../src/wordhero.h"
+using namespace std;
+
+static int failures = 0;
+
+#define CHECK(condition) \
+	do { if ( !(condition) ) { cerr << __FILE__ << ':' << __LINE__ << ": " #condition << endl; ++failures; } } while ( 0 )
+
+static const char* BOARD = "HAGOLLBRISEMMETW";
+
+// Every heap allocation the program makes, for testSolveViewAllocations.
+static long heapAllocations;
+
+void* operator new( size_t size )
+{
+	heapAllocations += 1;
+	void* block = malloc( size ? size : 1 );
+	if ( !block )
+	{
+		throw bad_alloc();
+	}
+	return block;
+}
+
+void operator delete( void* block ) noexcept
+{
+	free( block );
+}
+
+// Boards drawn with roughly English letter frequencies, so they hold words.
+static string randomBoard( int cells, unsigned& seed )
+{
+	static const char* LETTERS = "EEEEEAAAAIIIIOOONNNRRRTTTLLSSUDDGBCMPFHVWYKJXQZ";
+	string board;
+	for ( int i = 0; i < cells; ++i )
+	{
+		seed = seed*1103515245u + 12345u;
+		board += LETTERS[(seed >> 16) % 47];
+	}
+	return board;
+}
+
+static set<string> wordsOf( const WordHeroSolver& solver )
+{
+	return set<string>( solver.begin(), solver.end() );
+}
+
+// Every recorded path spells its word over distinct cells, each adjacent
+//   to the one before it.
+static bool pathsAreValid( const WordHeroSolver& solver, const string& board, const Topology& topology )
+{
+	for ( WordHeroSolver::const_iterator itr = solver.begin(); itr != solver.end(); ++itr )
+	{
+		const uint16_t* path = itr.path();
+		if ( !path )
+		{
+			return false;
+		}
+		set<int> used;
+		for ( size_t i = 0; i < itr->size(); ++i )
+		{
+			if ( board[path[i]] != (*itr)[i] || !used.insert( path[i] ).second
+				|| (i && !binary_search( topology.neighbors( path[i-1] ), topology.neighborsEnd( path[i-1] ), int(path[i]) )) )
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// countWords, score, solveTopK and verifyWords must count the same words as
+//   solve() when the constraints change the minimum length.
+static void testConstraintsMatchSolve( const Dictionary& dictionary )
+{
+	SolveConstraints suffix;
+	suffix.suffix = "ING";
+	suffix.minLength = 2;
+	SolveConstraints longWords;
+	longWords.minLength = 5;
+	SolveConstraints bounded;
+	bounded.minLength = 4;
+	bounded.maxLength = 5;
+	bounded.letter = 'e';
+	const SolveConstraints* cases[] = { &longWords, &suffix, &bounded };
+	const char* boards[] = { BOARD, "SINGRTAEIPNGLDES" };
+
+	WordHeroSolver solver( dictionary, 4, 4 );
+	for ( int c = 0; c < 3; ++c )
+	{
+		for ( int b = 0; b < 2; ++b )
+		{
+			solver.setConstraints( cases[c] );
+			solver.solve( boards[b] );
+			const vector<string> words( solver.begin(), solver.end() );
+			CHECK( solver.countWords( boards[b] ) == int(words.size()) );
+
+			// Everything ranks, so the top words are all of the words.
+			vector<string> top;
+			CHECK( solver.solveTopK( boards[b], 1000, WordHeroSolver::RANK_BY_LENGTH, chrono::seconds(10), top ) );
+			CHECK( set<string>( top.begin(), top.end() ) == set<string>( words.begin(), words.end() ) );
+
+			// A word solve() finds on the board is in the dictionary exactly
+			//   when it meets the constraints.
+			solver.setConstraints( NULL );
+			solver.solve( boards[b] );
+			const vector<string> all( solver.begin(), solver.end() );
+			solver.setConstraints( cases[c] );
+			vector<WordCheck> checks;
+			solver.verifyWords( boards[b], all, checks );
+			int accepted = 0;
+			for ( size_t i = 0; i < checks.size(); ++i )
+			{
+				CHECK( checks[i].onBoard );
+				accepted += checks[i].inDictionary ? 1 : 0;
+			}
+			CHECK( accepted == int(words.size()) );
+		}
+	}
+	solver.setConstraints( NULL );
+	SolveSummary summary;
+	solver.summarize( BOARD, summary );
+	solver.solve( BOARD );
+	CHECK( summary.words == uint32_t(distance( solver.begin(), solver.end() )) );
+}
+
+// verifyWords finds a candidate on the board exactly when solve() does.
+static void testVerifyMatchesSolve( const Dictionary& dictionary )
+{
+	unsigned seed = 35;
+	for ( int size = 4; size <= 6; ++size )
+	{
+		WordHeroSolver solver( dictionary, size, size );
+		for ( int i = 0; i < 4; ++i )
+		{
+			const string board = randomBoard( size*size, seed );
+			solver.solve( board );
+			const set<string> words = wordsOf( solver );
+			solver.solve( randomBoard( size*size, seed ) );
+			set<string> candidates = wordsOf( solver );
+			candidates.insert( words.begin(), words.end() );
+			const vector<string> list( candidates.begin(), candidates.end() );
+
+			vector<WordCheck> checks;
+			solver.verifyWords( board, list, checks );
+			CHECK( checks.size() == list.size() );
+			for ( size_t w = 0; w < checks.size(); ++w )
+			{
+				CHECK( checks[w].inDictionary );
+				CHECK( checks[w].onBoard == (words.count( list[w] ) > 0) );
+			}
+		}
+	}
+}
+
+// Recording paths keeps the words of solve(), and every path is one the
+//   player could swipe.
+static void testRecordedPaths( const Dictionary& dictionary )
+{
+	unsigned seed = 36;
+	const int sizes[][2] = { { 4, 4 }, { 5, 5 }, { 3, 7 }, { 8, 8 } };
+	for ( int s = 0; s < 4; ++s )
+	{
+		const int rows = sizes[s][0], cols = sizes[s][1];
+		const Topology grid = Topology::grid( rows, cols );
+		WordHeroSolver plain( dictionary, rows, cols );
+		WordHeroSolver solver( dictionary, rows, cols );
+		solver.setRecordPaths( true );
+		for ( int i = 0; i < 3; ++i )
+		{
+			const string board = randomBoard( rows*cols, seed );
+			plain.solve( board );
+			solver.solve( board );
+			CHECK( wordsOf( solver ) == wordsOf( plain ) );
+			CHECK( pathsAreValid( solver, board, grid ) );
+		}
+	}
+}
+
+// A chain of update() calls, each changing a few tiles, ends with the words
+//   and valid paths a full solve of the same board gives.
+static void testUpdateMatchesSolve( const Dictionary& dictionary )
+{
+	unsigned seed = 41;
+	for ( int size = 4; size <= 8; size += 2 )
+	{
+		const Topology grid = Topology::grid( size, size );
+		WordHeroSolver full( dictionary, size, size );
+		WordHeroSolver solver( dictionary, size, size );
+		solver.setRecordPaths( true );
+		string board = randomBoard( size*size, seed );
+		solver.solve( board );
+		for ( int step = 0; step < 6; ++step )
+		{
+			const string tiles = randomBoard( 1 + step % 3, seed );
+			for ( size_t t = 0; t < tiles.size(); ++t )
+			{
+				seed = seed*1103515245u + 12345u;
+				board[(seed >> 16) % board.size()] = tiles[t];
+			}
+			solver.update( board );
+			full.solve( board );
+			CHECK( wordsOf( solver ) == wordsOf( full ) );
+			CHECK( pathsAreValid( solver, board, grid ) );
+		}
+	}
+}
+
+// solveThrough finds the same words with and without the GADDAG: words of
+//   solve() with a path through the anchor, including every word whose
+//   recorded path crosses it.
+static void testSolveThrough( const Dictionary& dictionary )
+{
+	Dictionary withGaddag;
+	CHECK( withGaddag.load( "dictionary.dat" ) && withGaddag.loadGaddag( "gaddag.dat" ) );
+	unsigned seed = 42;
+	for ( int size = 4; size <= 7; ++size )
+	{
+		const Topology grid = Topology::grid( size, size );
+		WordHeroSolver full( dictionary, size, size );
+		WordHeroSolver forward( dictionary, size, size );
+		WordHeroSolver outward( withGaddag, size, size );
+		full.setRecordPaths( true );
+		forward.setRecordPaths( true );
+		outward.setRecordPaths( true );
+		for ( int i = 0; i < 3; ++i )
+		{
+			const string board = randomBoard( size*size, seed );
+			full.solve( board );
+			const set<string> all = wordsOf( full );
+			for ( int anchor = 0; anchor < size*size; anchor += size + 1 )
+			{
+				forward.solveThrough( board, anchor / size, anchor % size );
+				outward.solveThrough( board, anchor / size, anchor % size );
+				const set<string> through = wordsOf( outward );
+				CHECK( wordsOf( forward ) == through );
+				CHECK( includes( all.begin(), all.end(), through.begin(), through.end() ) );
+				CHECK( pathsAreValid( outward, board, grid ) );
+				for ( WordHeroSolver::const_iterator itr = outward.begin(); itr != outward.end(); ++itr )
+				{
+					CHECK( find( itr.path(), itr.path() + itr->size(), anchor ) != itr.path() + itr->size() );
+				}
+				for ( WordHeroSolver::const_iterator itr = full.begin(); itr != full.end(); ++itr )
+				{
+					if ( find( itr.path(), itr.path() + itr->size(), anchor ) != itr.path() + itr->size() )
+					{
+						CHECK( through.count( *itr ) );
+					}
+				}
+			}
+		}
+	}
+}
+
+// Every engine finds the words of the board engine, the original search,
+//   with and without recorded paths and through solveView.
+static void testEnginesMatchSolve( const Dictionary& dictionary )
+{
+	const WordHeroSolver::Engine engines[] = { WordHeroSolver::ENGINE_AUTO, WordHeroSolver::ENGINE_DICTIONARY,
+				WordHeroSolver::ENGINE_FRONTIER, WordHeroSolver::ENGINE_INTERLEAVED };
+	const int numberOfEngines = sizeof(engines) / sizeof(engines[0]);
+	unsigned seed = 43;
+	const int sizes[][2] = { { 4, 4 }, { 5, 5 }, { 3, 7 }, { 8, 8 }, { 12, 12 } };
+	for ( int s = 0; s < 5; ++s )
+	{
+		const int rows = sizes[s][0], cols = sizes[s][1];
+		const Topology grid = Topology::grid( rows, cols );
+		WordHeroSolver reference( dictionary, rows, cols );
+		reference.setEngine( WordHeroSolver::ENGINE_BOARD );
+		WordHeroSolver solver( dictionary, rows, cols );
+		for ( int i = 0; i < 3; ++i )
+		{
+			const string board = randomBoard( rows*cols, seed );
+			reference.solve( board );
+			const set<string> expected = wordsOf( reference );
+			for ( int e = 0; e < numberOfEngines; ++e )
+			{
+				solver.setEngine( engines[e] );
+				solver.setRecordPaths( false );
+				solver.solve( board );
+				CHECK( wordsOf( solver ) == expected );
+				// The frontier engine's masks hold 64 cells; larger boards fall back.
+				CHECK( engines[e] == WordHeroSolver::ENGINE_AUTO || solver.lastEngine() == engines[e]
+					|| (engines[e] == WordHeroSolver::ENGINE_FRONTIER && rows*cols > 64) );
+
+				const WordSpan view = solver.solveView( board.data(), board.size() );
+				set<string> viewed;
+				for ( size_t w = 0; w < view.size(); ++w )
+				{
+					viewed.insert( view[w].str() );
+				}
+				CHECK( viewed == expected );
+
+				solver.setRecordPaths( true );
+				solver.solve( board );
+				CHECK( wordsOf( solver ) == expected );
+				CHECK( pathsAreValid( solver, board, grid ) );
+			}
+		}
+	}
+}
+
+// Cutting a grid into tiles finds the words of one solve of the whole grid,
+//   whatever the tile size.
+static void testTiledMatchesSolve( const Dictionary& dictionary )
+{
+	unsigned seed = 44;
+	const int rows = 37, cols = 29;
+	const string grid = randomBoard( rows*cols, seed );
+	WordHeroSolver whole( dictionary, rows, cols );
+	whole.solve( grid );
+	const set<string> expected = wordsOf( whole );
+
+	string lines;
+	for ( int r = 0; r < rows; ++r )
+	{
+		lines += grid.substr( r*cols, cols ) + '\n';
+	}
+	const int tileSizes[] = { 1, 7, 16, 64 };
+	for ( int t = 0; t < 4; ++t )
+	{
+		TiledSolver tiled( dictionary, tileSizes[t], 2 );
+		istringstream in( lines );
+		CHECK( tiled.solve( in ) );
+		CHECK( tiled.rows() == rows && tiled.cols() == cols );
+		CHECK( set<string>( tiled.words().begin(), tiled.words().end() ) == expected );
+	}
+}
+
+// Every lane of a batch reports its board's words in solve() order,
+//   including the lanes of a last, partly filled batch.
+static void testBatchMatchesSolve( const Dictionary& dictionary )
+{
+	unsigned seed = 45;
+	const int sizes[][2] = { { 4, 4 }, { 5, 5 }, { 3, 7 } };
+	for ( int s = 0; s < 3; ++s )
+	{
+		const int rows = sizes[s][0], cols = sizes[s][1];
+		vector<string> boards;
+		for ( int i = 0; i < 2*BatchSolver::LANES + 5; ++i )
+		{
+			boards.push_back( randomBoard( rows*cols, seed ) );
+		}
+		BatchSolver batch( dictionary, rows, cols );
+		batch.solve( boards );
+		CHECK( batch.size() == int(boards.size()) );
+		WordHeroSolver solver( dictionary, rows, cols );
+		for ( size_t i = 0; i < boards.size(); ++i )
+		{
+			solver.solve( boards[i] );
+			vector<string> words;
+			batch.words( i, words );
+			CHECK( words == vector<string>( solver.begin(), solver.end() ) );
+		}
+	}
+}
+
+// Every word on a board, found by trying each letter of a DAWG list in turn
+//   along every path of the topology, as the original search did on a grid.
+static void bruteForce( const int* dawg, const Topology& topology, const string& board, int cell,
+			int list, string& str, vector<char>& used, set<string>& words )
+{
+	for ( int node = list; node; node = DAWG_NEXT(dawg, node) )
+	{
+		if ( DAWG_LETTER(dawg, node) != board[cell] )
+		{
+			continue;
+		}
+		str += board[cell];
+		// solve() reports words of three letters or more by default.
+		if ( DAWG_END_OF_WORD(dawg, node) && str.size() >= 3 )
+		{
+			words.insert( str );
+		}
+		used[cell] = 1;
+		for ( const int* next = topology.neighbors( cell ); next != topology.neighborsEnd( cell ); ++next )
+		{
+			if ( !used[*next] && DAWG_CHILD(dawg, node) )
+			{
+				bruteForce( dawg, topology, board, *next, DAWG_CHILD(dawg, node), str, used, words );
+			}
+		}
+		used[cell] = 0;
+		str.erase( str.size() - 1 );
+		return;
+	}
+}
+
+// On torus, hex, cube, masked and arbitrary graph layouts, every engine
+//   finds the words of a brute-force walk, along valid paths.
+static void testTopologiesMatchBruteForce( const Dictionary& dictionary )
+{
+	unsigned seed = 50;
+	vector<pair<int, int> > edges;
+	for ( int i = 0; i < 60; ++i )
+	{
+		seed = seed*1103515245u + 12345u;
+		edges.push_back( make_pair( (seed >> 8) % 20, (seed >> 20) % 20 ) );
+	}
+	const Topology layouts[] = { Topology::torus( 4, 4 ), Topology::torus( 5, 6 ), Topology::hex( 5, 5 ),
+				Topology::cube( 3 ), Topology::masked( Topology::grid( 5, 5 ), "XXXXX.XXX...X...XXX.XXXXX" ),
+				Topology::fromEdges( 20, edges ) };
+	const int sizes[][2] = { { 4, 4 }, { 5, 6 }, { 5, 5 }, { 9, 3 }, { 5, 5 }, { 4, 5 } };
+	const WordHeroSolver::Engine engines[] = { WordHeroSolver::ENGINE_AUTO, WordHeroSolver::ENGINE_BOARD,
+				WordHeroSolver::ENGINE_DICTIONARY, WordHeroSolver::ENGINE_FRONTIER, WordHeroSolver::ENGINE_INTERLEAVED };
+	for ( int t = 0; t < 6; ++t )
+	{
+		const Topology& topology = layouts[t];
+		WordHeroSolver solver( dictionary, sizes[t][0], sizes[t][1] );
+		CHECK( solver.setTopology( &topology ) );
+		for ( int i = 0; i < 3; ++i )
+		{
+			const string board = randomBoard( topology.cells(), seed );
+			set<string> expected;
+			string str;
+			vector<char> used( topology.cells(), 0 );
+			for ( int cell = 0; cell < topology.cells(); ++cell )
+			{
+				bruteForce( dictionary.nodes(), topology, board, cell, 1, str, used, expected );
+			}
+			for ( int e = 0; e < 5; ++e )
+			{
+				solver.setEngine( engines[e] );
+				solver.setRecordPaths( e % 2 == 0 );
+				solver.solve( board );
+				CHECK( wordsOf( solver ) == expected );
+				CHECK( e % 2 || pathsAreValid( solver, board, topology ) );
+			}
+		}
+	}
+}
+
+// update() to or from a board with wildcards gives the words of solve().
+static void testUpdateWithWildcards( const Dictionary& dictionary )
+{
+	const char* boards[] = { BOARD, "HAG?LLBRISEMMETW", "HAGOLLBR[AEIOU]SEMMETW", "HAG?LLBR[AEIOU]SEMMETW", BOARD };
+	WordHeroSolver full( dictionary, 4, 4 );
+	WordHeroSolver solver( dictionary, 4, 4 );
+	solver.setRecordPaths( true );
+	solver.solve( BOARD );
+	for ( int i = 1; i < 5; ++i )
+	{
+		solver.update( boards[i] );
+		full.solve( boards[i] );
+		CHECK( wordsOf( solver ) == wordsOf( full ) );
+	}
+}
+
+// A budget that has run out before the search starts still returns the
+//   longest word: the clock is first read a few hundred nodes in, and
+//   solveTopK follows the branches that can hold the longest words first.
+static void testTopKBestFirst( const Dictionary& dictionary )
+{
+	WordHeroSolver solver( dictionary, 5, 5 );
+	vector<string> words;
+	CHECK( !solver.solveTopK( "GSDTRPHEBOOOLRUUTEOSMSLRF", 1, WordHeroSolver::RANK_BY_LENGTH,
+				chrono::nanoseconds(0), words ) );
+	CHECK( words.size() == 1 && words[0] == "TROUBLESHOOTERS" );
+
+	CHECK( solver.solveTopK( "GSDTRPHEBOOOLRUUTEOSMSLRF", 1, WordHeroSolver::RANK_BY_LENGTH,
+				chrono::seconds(10), words ) );
+	CHECK( words.size() == 1 && words[0] == "TROUBLESHOOTERS" );
+}
+
+// The front ends read boards with countCells, so a wildcard board gets
+//   through the C ABI with the same words as solve().
+static void testWildcardBoards( const Dictionary& dictionary )
+{
+	string board = "hag?llbr[aeiou]SEMMETW";
+	CHECK( WordHeroSolver::countCells( board ) == 16 );
+	CHECK( board == "HAG?LLBR[AEIOU]SEMMETW" );
+	string bad = "HAG1LLBRISEMMETW";
+	CHECK( WordHeroSolver::countCells( bad ) == -1 );
+	bad = "HAGOLLBRISEMMET[W";
+	CHECK( WordHeroSolver::countCells( bad ) == -1 );
+
+	WordHeroSolver solver( dictionary, 4, 4 );
+	solver.solve( board );
+	const long expected = distance( solver.begin(), solver.end() );
+	wh_dictionary* handle = wh_dictionary_open( "dictionary.dat" );
+	wh_solver* cSolver = handle ? wh_solver_create( handle, 4, 4 ) : NULL;
+	vector<char> buffer( 1 << 20 );
+	wh_results results;
+	CHECK( cSolver && wh_solve( cSolver, board.data(), board.size(), &buffer[0], buffer.size(), &results ) == WH_OK
+		&& long(results.count) == expected );
+	wh_solver_destroy( cSolver );
+	wh_dictionary_close( handle );
+}
+
+// The cache's key is only the board, so a solve after setOverlay must not
+//   return the words cached before it.
+static void testCacheWithOverlay( const Dictionary& dictionary )
+{
+	ResultCache cache( 1 << 20 );
+	WordHeroSolver solver( dictionary, 4, 4 );
+	solver.setCache( &cache );
+	solver.solve( BOARD );
+	const vector<string> words( solver.begin(), solver.end() );
+	CHECK( !words.empty() );
+
+	Trie banned;
+	banned.insert( words[0] );
+	solver.setOverlay( NULL, &banned );
+	solver.solve( BOARD );
+	const vector<string> overlaid( solver.begin(), solver.end() );
+	CHECK( overlaid.size() + 1 == words.size() );
+	CHECK( find( overlaid.begin(), overlaid.end(), words[0] ) == overlaid.end() );
+
+	solver.setOverlay( NULL, NULL );
+	solver.solve( BOARD );
+	CHECK( vector<string>( solver.begin(), solver.end() ) == words );
+}
+
+// A board with too few or too many cells has no words, rather than the
+//   words of the last board's leftover cells.
+static void testMalformedBoards( const Dictionary& dictionary )
+{
+	WordHeroSolver solver( dictionary, 4, 4 );
+	const char* malformed[] = { "HAGO", "HAGOLLBRISEMMETWX", "HAGOLLBRISEMMET[W" };
+	for ( int i = 0; i < 3; ++i )
+	{
+		solver.solve( BOARD );
+		CHECK( solver.begin() != solver.end() );
+		solver.solve( malformed[i] );
+		CHECK( solver.begin() == solver.end() );
+		solver.solve( BOARD );
+		CHECK( solver.solveView( malformed[i], strlen( malformed[i] ) ).empty() );
+		CHECK( solver.countWords( malformed[i] ) == 0 );
+	}
+}
+
+// A dictionary file whose child index points past the last node is
+//   rejected instead of being walked off the end of the array.
+static void testCorruptDictionary()
+{
+	const char* path = "corrupt-test.dat";
+	const int nodes[] = { 3, 0, 'A' | (7 << 10), 'B' | 0x300 };
+	ofstream( path, ios::binary ).write( (const char*)nodes, sizeof(nodes) );
+	Dictionary dictionary;
+	CHECK( !dictionary.load( path ) );
+	CHECK( !dictionary.loadGaddag( path ) );
+	CHECK( wh_dictionary_open( path ) == NULL );
+	remove( path );
+}
+
+// A disk cache bucket whose blob lies past the data region is a miss, and
+//   a header whose regions do not fit the file gets the file rebuilt.
+static void testCorruptDiskCache( const Dictionary& dictionary )
+{
+	const char* path = "corrupt-test.cache";
+	const string key = "4x4" + string( BOARD );
+	const vector<uint32_t> ids( 3, 7 );
+	remove( path );
+	{
+		DiskCache cache;
+		CHECK( cache.open( path, dictionary, 64, 4096 ) );
+		CHECK( cache.insert( key, ids ) );
+	}
+
+	fstream file( path, ios::in | ios::out | ios::binary );
+	DiskCacheHeader header;
+	file.read( (char*)&header, sizeof(header) );
+	for ( uint64_t i = 0; i < header.buckets; ++i )
+	{
+		const streamoff at = header.bucketsAt + i*sizeof(DiskCacheBucket);
+		uint64_t hash;
+		file.seekg( at );
+		file.read( (char*)&hash, sizeof(hash) );
+		if ( hash )
+		{
+			const uint64_t offset = uint64_t(1) << 40;
+			file.seekp( at + offsetof(DiskCacheBucket, offset) );
+			file.write( (const char*)&offset, sizeof(offset) );
+		}
+	}
+	file.close();
+	vector<uint32_t> found;
+	{
+		DiskCache cache;
+		CHECK( cache.open( path, dictionary, 64, 4096 ) );
+		CHECK( !cache.lookup( key, found ) );
+	}
+
+	// The regions still add up to the file's size, but only by wrapping around.
+	file.open( path, ios::in | ios::out | ios::binary );
+	const uint64_t fileBytes = header.dataAt + header.dataBytes;
+	header.dataAt = uint64_t(1) << 63;
+	header.dataBytes = fileBytes - header.dataAt;
+	file.seekp( offsetof(DiskCacheHeader, dataAt) );
+	file.write( (const char*)&header.dataAt, sizeof(header.dataAt) );
+	file.write( (const char*)&header.dataBytes, sizeof(header.dataBytes) );
+	file.close();
+	{
+		DiskCache cache;
+		CHECK( cache.open( path, dictionary, 64, 4096 ) );
+		CHECK( cache.entries() == 0 && !cache.lookup( key, found ) );
+		CHECK( cache.insert( key, ids ) && cache.lookup( key, found ) && found == ids );
+	}
+	remove( path );
+}
+
+// Once its arenas have grown to fit the largest result, solveView
+//   allocates nothing, whichever engine the board picks.
+static void testSolveViewAllocations( const Dictionary& dictionary )
+{
+	const char* boards[] = { BOARD, "SINGRTAEIPNGLDES", "GSDTRPHEBOOOLRUUTEOSMSLRF", "HAG?LLBRISEMMETW" };
+	const int sizes[] = { 4, 4, 5, 4 };
+	WordHeroSolver small( dictionary, 4, 4 );
+	WordHeroSolver large( dictionary, 5, 5 );
+	for ( int pass = 0; pass < 2; ++pass )
+	{
+		const long before = heapAllocations;
+		size_t words = 0;
+		for ( int i = 0; i < 4; ++i )
+		{
+			WordHeroSolver& solver = sizes[i] == 4 ? small : large;
+			words += solver.solveView( boards[i], strlen( boards[i] ) ).size();
+		}
+		CHECK( words > 0 );
+		// The cold pass sizes the arenas, which shows the count is live.
+		CHECK( pass == 0 ? heapAllocations > before : heapAllocations == before );
+	}
+}
+
+// A shared-memory server thread answers a client with the words of solve(),
+//   including requests submitted while it sleeps on its futex and a ring
+//   of two slots that only drains as the client releases answers.
+static void testShmRoundTrip( const Dictionary& dictionary )
+{
+	const string name = "/wordhero-test-" + to_string( getpid() );
+	ShmSolverServer server( dictionary, 4, 4, 2 );
+	CHECK( server.create( name.c_str() ) );
+	thread serving( &ShmSolverServer::run, &server );
+	ShmSolverClient client;
+	CHECK( client.open( name.c_str() ) );
+	const int fd = shm_open( name.c_str(), O_RDONLY, 0 );
+	void* mapped = fd < 0 ? MAP_FAILED : mmap( NULL, sizeof(ShmHeader), PROT_READ, MAP_SHARED, fd, 0 );
+	CHECK( mapped != MAP_FAILED );
+	if ( fd >= 0 )
+	{
+		close( fd );
+	}
+	if ( mapped == MAP_FAILED || !client.rows() )
+	{
+		server.stop();
+		serving.join();
+		return;
+	}
+	const ShmHeader* header = (const ShmHeader*)mapped;
+
+	unsigned seed = 28;
+	vector<string> boards;
+	for ( int i = 0; i < 7; ++i )
+	{
+		boards.push_back( randomBoard( 16, seed ) );
+	}
+	WordHeroSolver solver( dictionary, 4, 4 );
+	const chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::seconds(10);
+	size_t submitted = 0, answered = 0;
+	bool sawSleep = false;
+	while ( answered < boards.size() && chrono::steady_clock::now() < deadline )
+	{
+		// Every few answers, let the server go idle until it sleeps, so the
+		//   next submit has to wake it.
+		if ( answered % 3 == 0 && submitted == answered )
+		{
+			while ( !header->serverWaiting.load() && chrono::steady_clock::now() < deadline )
+			{
+				this_thread::sleep_for( chrono::milliseconds(1) );
+			}
+			sawSleep = sawSleep || header->serverWaiting.load();
+		}
+		while ( submitted < boards.size() && client.submit( submitted, boards[submitted].data(), 16 ) )
+		{
+			++submitted;
+		}
+		const ShmResponse* response = client.poll();
+		if ( !response )
+		{
+			this_thread::yield();
+			continue;
+		}
+		CHECK( response->requestId == answered && response->status == SHM_OK );
+		solver.solve( boards[answered] );
+		vector<string> words;
+		for ( uint32_t i = 0; i < response->count; ++i )
+		{
+			int length;
+			const char* word = client.word( ShmSolverClient::wordIds( response )[i], &length );
+			words.push_back( string( word, length ) );
+		}
+		CHECK( words == vector<string>( solver.begin(), solver.end() ) );
+		client.release();
+		++answered;
+	}
+	CHECK( answered == boards.size() );
+	CHECK( sawSleep );
+	munmap( mapped, sizeof(ShmHeader) );
+	server.stop();
+	serving.join();
+}
+
+int main()
+{
+	Dictionary dictionary;
+	if ( !dictionary.load( "dictionary.dat" ) )
+	{
+		cerr << "could not initialize the DAWG (bad file?)" << endl;
+		return 1;
+	}
+	testConstraintsMatchSolve( dictionary );
+	testVerifyMatchesSolve( dictionary );
+	testRecordedPaths( dictionary );
+	testUpdateMatchesSolve( dictionary );
+	testSolveThrough( dictionary );
+	testEnginesMatchSolve( dictionary );
+	testTiledMatchesSolve( dictionary );
+	testBatchMatchesSolve( dictionary );
+	testTopologiesMatchBruteForce( dictionary );
+	testUpdateWithWildcards( dictionary );
+	testTopKBestFirst( dictionary );
+	testWildcardBoards( dictionary );
+	testCacheWithOverlay( dictionary );
+	testMalformedBoards( dictionary );
+	testCorruptDictionary();
+	testCorruptDiskCache( dictionary );
+	testSolveViewAllocations( dictionary );
+	testShmRoundTrip( dictionary );
+	cout << (failures ? "FAILED" : "ok") << endl;
+	return failures;
+}